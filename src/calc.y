@@ -3,24 +3,23 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
-
-int yyparse(void);
-int yyerror(char* errmsg);
-int yylex();
+#include <string.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <float.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
 
 typedef enum { false, true } bool;
 
 /**
-*   Keeps track of active distributions.
-*   A warning is displayed if a distribution remains after the program is done
-*   (indicates a memory leak).
+*   State of one evaluation (see below). Every function that allocates, rolls
+*   or prints takes the context it works in as its first argument.
 */
-int active_distribution_count;
+typedef struct EvalContext EvalContext;
 
-/**
-*   Prints the Result in a clean format. 
-*/
-double printResult(double result);
+int yyerror(void* scanner, EvalContext* ctx, const char* errmsg);
 
 /**
 *   Represents a distribution of any dice or combination of dice.
@@ -32,9 +31,23 @@ double printResult(double result);
 *   (NOTE:  The probabilities might be weighted, to get the real probability (summing to 1)
 *           you have to divide all values by the sum of all values.)
 *
+*   The array has one of two forms (see getValue):
+*   -   dense: cell i holds the value constant + offset + i, "values" is NULL.
+*       (e.g. "100d6" has the offset 100 and 501 cells for the values 100 to 600)
+*   -   sparse: cell i holds the value constant + values[i], the values are sorted ascending.
+*       Used for results with many gaps, like products (see chooseForm).
+*
 *   The member "constant" is a constant value added to the total value when resolved.
 *   With this member, the distribution can represent a single number by setting 
 *   the size and distribution to 0.
+*
+*   The member "sampler" caches the alias table used for rolling. It is built on the
+*   first roll and reused by all following rolls of the same distribution.
+*
+*   The member "key" identifies the content of an uncertain distribution by the way it
+*   was computed (see apply). Distributions that depend on a roll have the key 0.
+*
+*   The member "next_free" links deleted distributions inside the arena for reuse.
 */
 typedef struct Distribution
 {
@@ -42,20 +55,148 @@ typedef struct Distribution
 
     double* distribution;
     int size;
+
+    int offset;
+    double* values;
+
+    struct Sampler* sampler;
+    unsigned long long key;
+
+    struct Distribution* next_free;
 } Distribution;
 
 /**
-*   Creates a new distribution on the heap with the given size and constant.
+*   Number of distributions allocated at once by the arena.
+*/
+#define ARENA_CHUNK_SIZE 256
+
+typedef struct ArenaChunk
+{
+    Distribution distributions[ARENA_CHUNK_SIZE];
+    struct ArenaChunk* next;
+} ArenaChunk;
+
+/**
+*   Arena holding the distributions of the current statement.
+*
+*   Distributions are handed out from chunks, deleted ones are reused through the "free_list".
+*   After a line has been resolved all distributions are released at once (see releaseStatement),
+*   keeping the chunks for the next statement.
+*/
+typedef struct DistributionArena
+{
+    ArenaChunk* first;
+    ArenaChunk* current;
+    int used;
+
+    Distribution* free_list;
+} DistributionArena;
+
+/**
+*   Number of size classes of the buffer pool, class k holds buffers for 2^k values.
+*/
+#define POOL_CLASS_COUNT 32
+
+/**
+*   Maximal number of bytes the pool keeps after a statement for the following ones.
+*/
+#define POOL_RETAIN_LIMIT (64 * 1024 * 1024)
+
+/**
+*   Pool of probability buffers, sorted into size classes of powers of two.
+*   Released buffers are kept in a list per class (linked through their first value)
+*   and handed out again to the next request of the same class.
+*/
+typedef struct BufferPool
+{
+    double* free_buffers[POOL_CLASS_COUNT];
+    size_t retained_bytes;
+    size_t used_bytes; // handed out and not yet released
+} BufferPool;
+
+/**
+*   Returns a buffer of at least size values from the pool (uninitialized).
+*/
+double* acquireBuffer(EvalContext* ctx, int size);
+
+/**
+*   Returns a buffer acquired for size values to the pool.
+*/
+void releaseBuffer(EvalContext* ctx, double* buffer, int size);
+
+/**
+*   Returns the size class of a buffer for size values.
+*/
+int getSizeClass(int size);
+
+/**
+*   Releases all distributions of the finished statement at once and trims the pool.
+*   Distributions that were not deleted are counted as leaks (see active_distribution_count).
+*/
+void releaseStatement(EvalContext* ctx);
+
+/**
+*   Alias table (Vose's method) of a distribution, allowing to roll it in O(1).
+*
+*   Rolling picks one of the "size" columns uniformly and keeps it with the probability
+*   "threshold", otherwise it returns the column's "alias".
+*/
+typedef struct Sampler
+{
+    double* threshold;
+    int* alias;
+    int size;
+} Sampler;
+
+/**
+*   State of the xoshiro256** pseudo random number generator used for all rolls.
+*   (Replaces rand(), which only offers RAND_MAX different values and can not be seeded
+*   independently of other users.)
+*/
+typedef struct RandomState
+{
+    unsigned long long s[4];
+} RandomState;
+
+/**
+*   Seeds the random number generator. The same seed reproduces the same rolls.
+*   (The state is expanded from the seed with splitmix64.)
+*/
+void seedRandom(EvalContext* ctx, unsigned long long seed);
+
+/**
+*   Returns the next 64 random bits.
+*/
+unsigned long long nextRandom(EvalContext* ctx);
+
+/**
+*   The same functions on a given generator state, for generators of their own
+*   (e.g. the threads of the Monte Carlo estimator). uniformState returns a uniform
+*   random double in [0, 1) with the full 53 bit resolution.
+*/
+void seedState(RandomState* state, unsigned long long seed);
+unsigned long long stepState(RandomState* state);
+double uniformState(RandomState* state);
+
+/**
+*   Creates a new distribution in the arena with the given size and constant.
 *   Initializes all possible values with initVal. 
 */
-Distribution * createDistribution(int size, double initVal, double constant);
+Distribution * createDistribution(EvalContext* ctx, int size, double initVal, double constant);
 
 /**
-*   Deletes a distribution that was allocated on the heap.
+*   Deletes a distribution that was allocated in the arena.
 *   All Distributions created by createDistribution or any of the functions
 *   returning a Distribution Pointer should be deleted with this function.
+*   (Its buffer goes back to the pool and the distribution is reused by the arena.)
+*/
+void deleteDistribution(EvalContext* ctx, Distribution * dist);
+
+/**
+*   Creates a new sparse distribution in the arena with room for size values.
+*   The values are uninitialized, all weights are 0.
 */
-void deleteDistribution(Distribution * dist);
+Distribution * createSparseDistribution(EvalContext* ctx, int size, double constant);
 
 /**
 *   Indicates wheather the distribution has an uncertain part.
@@ -64,10 +205,23 @@ void deleteDistribution(Distribution * dist);
 */
 bool isUncertain(Distribution * dist);
 /**
-*   Returns the maximal possible value the distribution could resolve to.
-*   (Effectively equals size + constant) 
+*   Indicates wheather the distribution is stored in the sparse form.
+*/
+bool isSparse(Distribution * dist);
+/**
+*   Indicates wheather all values of the distribution lie on the integer grid of its constant
+*   (always true for the dense form).
+*/
+bool isIntegral(Distribution * dist);
+/**
+*   Indicates wheather the distribution can be stored in the dense form
+*   (integral values, with the offset and size fitting into an int).
+*/
+bool canDensify(Distribution * dist);
+/**
+*   Returns the value of the given cell of the distribution array (including the constant).
 */
-double getMax(Distribution * dist);
+double getValue(Distribution * dist, int index);
 /**
 *   Returns the sum of all weights of the distribution.
 *   (usually 1 unless the array is weighted).
@@ -77,55 +231,349 @@ double getTotalWeight(Distribution * dist);
 /**
 *   Prints the distribution in a nice format.
 */
-void print(Distribution * dist);
+void print(EvalContext* ctx, Distribution * dist);
 
 /**
 *   Resolves the final distribution before displaying the resulting double.
 *   (Rolls the distribution if uncertain, returns the constant otherwise)
 */
-double resolve(Distribution* dist);
+double resolve(EvalContext* ctx, Distribution* dist);
+
+/**
+*   Creates a deep copy of the given distribution in the arena.
+*/
+Distribution * copyDistribution(EvalContext* ctx, Distribution * dist);
+
+/**
+*   Distributions filling less than this fraction of the range between their smallest
+*   and largest value are stored in the sparse form.
+*/
+#define SPARSE_DENSITY 0.25
+
+/**
+*   Values closer than this are considered equal (e.g. by prob).
+*/
+#define VALUE_EPSILON 1e-9
+
+/**
+*   Stores the distribution in the form fitting its density (see SPARSE_DENSITY),
+*   dropping cells without weight at the borders of the dense form and everywhere in the sparse form.
+*   Takes ownership of dist, returns either dist itself or a replacement.
+*/
+Distribution * chooseForm(EvalContext* ctx, Distribution * dist);
+
+/**
+*   A value with its weight, see collectValues.
+*/
+typedef struct WeightedValue
+{
+    double value;
+    double weight;
+} WeightedValue;
+
+/**
+*   Creates a distribution from count (value, weight) pairs, the values are relative to constant.
+*   Pairs with equal values are merged, the result is stored in the form fitting its density.
+*   Sorts the given array in place.
+*/
+Distribution * collectValues(EvalContext* ctx, WeightedValue* pairs, int count, double constant);
+
+/**
+*   Results of sums and products of values with more than this many distinct values fail
+*   the statement (see combinePairs).
+*/
+#define MAX_RESULT_CELLS (1 << 26)
+
+/**
+*   Integral results are added into a dense array over their range while the range has
+*   at most this many cells per pair of values, into a hash table keyed by the result otherwise.
+*/
+#define PAIR_DENSE_FACTOR 4
+
+/**
+*   Combines every pair of values of two distributions into their sum (or their product
+*   if multiply is set), weighted by the product of their probabilities. A constant takes
+*   part as a single value with the full weight.
+*   Integral results are added straight into their cells (see PAIR_DENSE_FACTOR), other
+*   results are collected as pairs and sorted (see collectValues).
+*   Fails the statement (see failStatement) and returns the constant 0 if the result
+*   would have more than MAX_RESULT_CELLS values or the memory runs out.
+*/
+Distribution* combinePairs(EvalContext* ctx, Distribution* d1, Distribution* d2, bool multiply);
+
+/**
+*   Adds weight to the entry of the integral value key in an open addressing hash table
+*   (keys LLONG_MIN mark empty slots), doubling the table when it gets three quarters full.
+*   Returns false if the table would exceed MAX_RESULT_CELLS entries or the memory runs out.
+*/
+bool addToTable(long long** keys, double** weights, int* capacity, int* count, long long key, double weight);
+
+/**
+*   Compares two WeightedValues by their value (for qsort).
+*/
+int compareValues(const void* a, const void* b);
+
+/**
+*   Creates a dense copy of a distribution whose values are integral (see isIntegral),
+*   spanning the cells from the first to the last one with a weight.
+*/
+Distribution * densify(EvalContext* ctx, Distribution * dist);
+
+/**
+*   Operands with a direct cost (size_a * size_b) below this many times the
+*   FFT cost (L * log2(L), L being the padded transform length) are convolved directly.
+*/
+#define CONVOLUTION_FFT_FACTOR 8
+
+/**
+*   Convolves two weight arrays: out[i + j] = sum(a[i] * scale_a * b[j] * scale_b).
+*   out must hold size_a + size_b - 1 values, which are overwritten.
+*
+*   Small operands are convolved directly, large ones with a FFT (O(L log L)).
+*   The FFT result has an absolute error of about 1e-15 times the largest resulting
+*   value, which would drown the tails of the distribution. So only the cells above
+*   CONVOLUTION_RELATIVE_BOUND times the largest value are taken from a transform; the
+*   remaining ones are transformed again with exponentially tilted operands
+*   (a[i] * e^(theta * i), which turns into out[k] * e^(theta * k)), moving the largest
+*   value of the tilted result just beyond the edge of the cells found so far. Such a pass
+*   only transforms the operand cells reaching the remaining cells on one side of the
+*   mode, so the transforms get shorter towards the tails. Every transform leaves out the
+*   operand cells far below the largest tilted one (see CONVOLUTION_OPERAND_BOUND), so its
+*   length follows the spread of the operands rather than their range.
+*   Cells that no pair of operand cells reaches are exactly 0, cells below the smallest
+*   normal double are 0 as well, and whatever is left after CONVOLUTION_MAX_PASSES
+*   transforms is summed directly.
+*
+*   Returns the number of element operations (multiplied pairs or butterflies).
+*/
+double convolve(EvalContext* ctx, double* a, int size_a, double scale_a, double* b, int size_b, double scale_b, double* out);
+
+/**
+*   Cells of a transformed result at least this fraction of its largest value
+*   are exact up to a relative error of about 1e-6.
+*/
+#define CONVOLUTION_RELATIVE_BOUND 1e-9
+
+/**
+*   Maximal number of (tilted) transforms of a convolution, see convolve.
+*/
+#define CONVOLUTION_MAX_PASSES 32
+
+/**
+*   Tilted operand cells below this fraction of the largest one are left out of a transform:
+*   even millions of them change the cells taken from it by less than its error.
+*/
+#define CONVOLUTION_OPERAND_BOUND 1e-25
+
+/**
+*   Narrows [*first, *last] to the cells whose tilted log (see convolveTilted) is at least
+*   the log of CONVOLUTION_OPERAND_BOUND times the largest tilted cell in that range.
+*/
+void trimTilted(double* log_a, double theta, int* first, int* last);
+
+/**
+*   Convolves two operands given by the logs of their scaled cells (-INFINITY for 0),
+*   tilted by e^(theta * i), with a FFT of length n, using re and im as buffers: afterwards
+*   im[k] holds out[k] * e^(theta * k - shift), the returned shift keeps the tilted values
+*   in the range of a double.
+*/
+double convolveTilted(double* log_a, int size_a, double* log_b, int size_b, double theta, double* re, double* im, int n);
+
+/**
+*   Squares the spectrum of z = re + i * im: afterwards im holds twice the convolution
+*   of the initial re and im (unscaled by n, see fft).
+*/
+void squareSpectrum(double* re, double* im, int n);
+
+/**
+*   In-place iterative radix-2 FFT on separate real and imaginary arrays.
+*   n has to be a power of two, inverse selects the (unscaled) backwards transform.
+*/
+void fft(double* re, double* im, int n, bool inverse);
 
 /**
 *   Adds two Distributions, creating a new distribution.
 *   (e.g. add(1d6, 1d6) := 1d6+1d6 = 2d6)
+*   Two uncertain distributions are convolved (see convolve), both normalized once.
+*   Sparse operands are convolved in their dense form if that is cheaper than
+*   adding all pairs of values, otherwise all pairs are combined (see combinePairs).
 */
-Distribution* add(Distribution* d1, Distribution* d2);
+Distribution* add(EvalContext* ctx, Distribution* d1, Distribution* d2);
 
 /**
 *   Multiplies two Distributions, creating a new distribution.
 *   (e.g. times(1d6, 1d6) := 1d6 * 1d6)
+*   The products of all pairs of values are combined (see combinePairs),
+*   so the result is usually sparse.
 */
-Distribution* times(Distribution* d1, Distribution* d2);
+Distribution* times(EvalContext* ctx, Distribution* d1, Distribution* d2);
 
 /**
 *   Applies the dice operator to two Distributions, creating a new distribution.
 *   The default case is with two constants, generating a distribution for a given dice:
 *   dice(1, 6) := 1d6
 *   
-*   If one of the two arguments are uncertain distributions, rolls them first to get
-*   a constant value and use that to generate the new distribution.
-*   dice(1d6, 1d8) := 4d7 (could equal 1d1, 1d2, ..., 1d8, 2d1, ..., 6d8)
-*   
-*   NOTE: This could be improved, so that the resulting probability distributions represent the probability
-*   of the combined expression. This requires some more complex algorithms however.
+*   If one of the two arguments are uncertain distributions, the result is the mixture
+*   of all combinations of count and sides, weighted by their probabilities (see mixDice):
+*   dice(1d2, 1d6) := 1/2 * 1d6 + 1/2 * 2d6
+*   If that would exceed the budget of the context (see estimateDice), the mixture is
+*   estimated by sampling (see sampleDice) instead.
+*
+*   NdS is built by repeated squaring of 1dS (see power), taking O(log N) additions.
+*   Counts and sides are truncated to integers, a count or number of sides below 1 results in 0.
+*/
+Distribution* dice(EvalContext* ctx, Distribution* d1, Distribution* d2);
+
+/**
+*   Returns the possible values of a count or number of sides of dice with their
+*   probabilities (summing up to 1), sorted: values are truncated to integers and
+*   values below 1 are merged into 0. The array has to be freed.
+*/
+WeightedValue* getDiceOutcomes(Distribution* d, int* count);
+
+/**
+*   Estimates the element operations and the bytes needed to compute dice(d1, d2) exactly.
+*   Stops counting once the budget of the context is exceeded.
+*/
+void estimateDice(EvalContext* ctx, Distribution* d1, Distribution* d2, double* operations, double* bytes);
+
+/**
+*   Computes the exact distribution of dice with an uncertain count or number of sides:
+*   for every number of sides s, the powers of 1ds for the possible counts n are built one
+*   after the other (each from the previous one) and added up weighted by P(N = n) * P(S = s).
+*/
+Distribution* mixDice(EvalContext* ctx, Distribution* d1, Distribution* d2);
+
+/**
+*   The Monte Carlo estimator rolls up to this many dice of a sample one by one. Larger
+*   counts are split into groups of 2^k dice (as in power), the sum of every group of at
+*   least this many dice is drawn at once from its exact distribution (see buildDiceTables).
+*/
+#define MONTE_CARLO_EXACT_DICE 64
+
+/**
+*   Without tables for their number of sides, up to this many dice are still rolled one by one;
+*   the sum of more dice is drawn from the normal distribution with the same mean and variance.
+*   Estimates using that approximation come without confidence intervals.
+*/
+#define MONTE_CARLO_ROLLED_DICE 4096
+
+/**
+*   Number of tables per number of sides, table k holding the sum of 2^k dice.
+*/
+#define MONTE_CARLO_LEVELS 31
+
+/**
+*   Number of independently seeded parts of a Monte Carlo estimation. The parts are spread
+*   over the threads, so the estimate does not depend on the number of threads.
+*/
+#define MONTE_CARLO_CHUNKS 64
+
+/**
+*   Estimates the distribution of dice with an uncertain count or number of sides from
+*   random samples (a histogram of the sampled sums, normalized), using several threads.
+*   The 95% confidence interval of every probability p is p +- 1.96 * sqrt(p * (1 - p) / samples),
+*   unless sums had to be approximated (see MONTE_CARLO_ROLLED_DICE).
+*/
+Distribution* sampleDice(EvalContext* ctx, Distribution* d1, Distribution* d2);
+
+/**
+*   Shared state of the threads of one Monte Carlo estimation. The threads take the
+*   chunks one after the other; chunk k is rolled with its own generator seeded from
+*   "seed" and k, and writes its sums to its part of "values".
+*
+*   "sides" holds the "side_count" possible numbers of sides in ascending order, the first
+*   "table_count" of them come with "tables" (see buildDiceTables): the sum of 2^k dice with
+*   sides[j] sides is tables[j * MONTE_CARLO_LEVELS + k], NULL for groups rolled one by one.
+*   "approximated" counts the samples drawn from the normal approximation.
+*/
+typedef struct MonteCarloJob
+{
+    Distribution* counts;
+    Distribution* dice_sides;
+    double* values;
+    long samples_per_chunk;
+    unsigned long long seed;
+
+    WeightedValue* sides;
+    int side_count;
+    int table_count;
+    Distribution** tables;
+
+    pthread_mutex_t lock;
+    int next_chunk;
+    long approximated;
+} MonteCarloJob;
+
+/**
+*   Builds the tables of a Monte Carlo estimation for the numbers of sides from the smallest
+*   one up, as long as all of them fit into the exact budget of the context: for 2^k from
+*   MONTE_CARLO_EXACT_DICE up to the largest count, the exact distribution of 2^k dice
+*   (squared from 1ds one after the other, as in power) with its alias table.
+*/
+void buildDiceTables(EvalContext* ctx, MonteCarloJob* job, Distribution* counts, Distribution* sides);
+
+/**
+*   Returns the tables of a Monte Carlo estimation for s sides, NULL if there are none.
+*/
+Distribution** findDiceTables(MonteCarloJob* job, double s);
+
+/**
+*   Thread function of the Monte Carlo estimator, rolls chunks until none are left.
+*/
+void* runMonteCarlo(void* arg);
+
+/**
+*   Rolls a count or number of sides with the given generator (using its prebuilt alias table).
+*/
+double drawOperand(RandomState* state, Distribution* d);
+
+/**
+*   Estimates the element operations of a convolution of two arrays of the given sizes (see convolve).
 */
-Distribution* dice(Distribution* d1, Distribution* d2);
+double estimateConvolution(double size_a, double size_b);
 
 /**
-*   Returns the average of the distribution as a constant inside a new distribution.
+*   Adds the distribution n times to itself (n >= 1) by exponentiation by squaring,
+*   creating a new distribution. (e.g. power(1d6, 3) := 1d6+1d6+1d6 = 3d6)
 */
-Distribution* avg(Distribution* d);
+Distribution* power(EvalContext* ctx, Distribution* base, int n);
 
 /**
 *   Rolls the distribution (generates a random value using the stored probabilities for that value)
 *   and returns the rolled value as a constant inside a new distribution.
 */
-Distribution* roll(Distribution* d);
+Distribution* roll(EvalContext* ctx, Distribution* d);
+
+/**
+*   Rolls the distribution n times and returns the results as a new distribution,
+*   that stores how often each value was rolled as its weight (a histogram of the rolls).
+*   (e.g. avg(roll(2d6, 1000)) returns the average of 1000 rolls of 2d6)
+*
+*   The count is rolled first if it is uncertain. Counts below 1 result in the constant 0.
+*/
+Distribution* rollMany(EvalContext* ctx, Distribution* d, Distribution* count);
+
+/**
+*   Returns the index of a randomly chosen cell of the distribution array, using
+*   (and building if necessary) the alias table cached on the distribution.
+*/
+int sampleIndex(EvalContext* ctx, Distribution* d);
+
+/**
+*   Returns the index of a randomly chosen cell using the given alias table and generator.
+*/
+int drawIndex(RandomState* state, Sampler* sampler);
+
+/**
+*   Builds the alias table for the given distribution.
+*/
+Sampler* createSampler(Distribution* d);
 
 /**
-*   Recursive helper function for rolling a distribution.
+*   Frees an alias table.
 */
-int divideAndRoll(double* prob, int start_index, int end_index, double sectionWeight);
+void deleteSampler(Sampler* sampler);
 
 /**
 *   Returns the probability that the value of the second distribution resolves to the constant 
@@ -133,303 +581,2033 @@ int divideAndRoll(double* prob, int start_index, int end_index, double sectionWe
 *   If the first distribution is uncertain, rolls it to reduce it to a constant value.
 *   (e.g. prob(1d6, 1d8) would roll 1d6 to get 4 and return the probability that 1d8 rolls 4).
 */
-Distribution* prob(Distribution* d1, Distribution* d2);
+Distribution* prob(EvalContext* ctx, Distribution* d1, Distribution* d2);
 
+/**
+*   Operators whose results can be reused by the cache.
+*/
+typedef enum { OP_ADD, OP_TIMES, OP_DICE, OP_PROB } Operator;
 
-%}
+/**
+*   Applies an operator to one (d2 = NULL) or two distributions, creating a new distribution.
+*
+*   Results of deterministic operations are looked up in and stored into the
+*   distribution cache, keyed by the operator and the canonical keys of the operands.
+*   Operations that roll an operand (prob with an uncertain first operand), estimated
+*   dice (see sampleDice) and every roll are never cached, neither are constant results
+*   (operators other than dice on two constants), which are cheaper to compute than to look up.
+*/
+Distribution* apply(EvalContext* ctx, Operator op, Distribution* d1, Distribution* d2);
 
+/**
+*   Returns the canonical key of a distribution: a hash of the value for constants,
+*   the stored key (0 if unknown) for uncertain distributions.
+*/
+unsigned long long getKey(Distribution* dist);
 
-%union {
-  double f;
-  int i;
-  struct Distribution * d;
-}
+/**
+*   Mixes the operator and the keys of its operands into a new key.
+*   Returns 0 (unknown) if any of the operand keys is unknown.
+*/
+unsigned long long combineKeys(Operator op, unsigned long long key_1, unsigned long long key_2);
 
-%token INTEGER DOUBLE
-%token ROLL AVG PROB SEPERATOR
-%token PLUS TIMES DICE
-%token BRACKET_OPEN BRACKET_CLOSE EOL
+/**
+*   Scrambles the bits of a 64 bit value (the splitmix64 finalizer).
+*/
+unsigned long long mixBits(unsigned long long z);
+
+/**
+*   Kinds of nodes of an expression.
+*/
+typedef enum {
+  EXPR_VALUE, EXPR_ADD, EXPR_TIMES, EXPR_DICE, EXPR_ROLL, EXPR_ROLL_MANY,
+  EXPR_AVG, EXPR_VAR, EXPR_STDDEV, EXPR_PROB
+} ExpressionKind;
+
+/**
+*   A node of the expression of a statement, as parsed. Expressions are evaluated lazily:
+*   avg, var and stddev only need the moments of their operand (see getMoments), which
+*   are computed from the moments of its parts without building their distributions.
+*   Distributions are only built (see materialize) where prob, roll or the result of the
+*   statement need one.
+*
+*   Every node is a separate random variable, independent of all other nodes
+*   (e.g. 1d6+1d6 adds two independent dice).
+*
+*   The member "drawn" keeps the distribution of a node whose own operation drew random
+*   numbers (a roll, prob rolling its first operand, estimated dice), so the node keeps
+*   its value if it is materialized again (see getMoments).
+*/
+typedef struct Expression
+{
+    ExpressionKind kind;
+    double constant; // EXPR_VALUE
+    struct Expression* left;
+    struct Expression* right;
+    Distribution* drawn;
+} Expression;
+
+/**
+*   Mean and variance of an expression, with bounds of its values.
+*   "integral" indicates that all values are integers.
+*/
+typedef struct Moments
+{
+    double mean;
+    double variance;
+    double min;
+    double max;
+    bool integral;
+} Moments;
+
+/**
+*   Creates an expression node of the given kind with up to two operands.
+*/
+Expression* createExpression(EvalContext* ctx, ExpressionKind kind, Expression* left, Expression* right, double constant);
+
+/**
+*   Frees an expression with all of its operands.
+*/
+void deleteExpression(EvalContext* ctx, Expression* expr);
+
+/**
+*   Builds the distribution of an expression, creating a new distribution.
+*   Rolls are done in the order of the input.
+*/
+Distribution* materialize(EvalContext* ctx, Expression* expr);
+
+/**
+*   Computes the moments of an expression:
+*   X+Y: the means and variances add up (independent operands).
+*   X*Y: E = E[X]E[Y], Var = Var(X)Var(Y) + Var(X)E[Y]^2 + Var(Y)E[X]^2.
+*   NdS: a sum of N independent dice with S sides, where N and S may be random themselves
+*        (compound sum): with m = (S+1)/2 and v = (S^2-1)/12, the moments of one die,
+*        E = E[N]E[m], Var = E[N]E[v] + Var(N)E[m^2] + E[N]^2 Var(m).
+*   Takes O(number of nodes). Other nodes (rolls, prob, or dice with counts below 0,
+*   sides below 1 or fractions) are materialized, without drawing their rolls again.
+*/
+void getMoments(EvalContext* ctx, Expression* expr, Moments* moments);
+
+/**
+*   Computes the moments of a distribution.
+*/
+void getDistributionMoments(Distribution* dist, Moments* moments);
+
+/**
+*   A cached result. The entries are chained per hash bucket and linked
+*   from the most to the least recently used one for the eviction.
+*/
+typedef struct CacheEntry
+{
+    Operator op;
+    unsigned long long key, key_1, key_2;
+    Distribution value;
+
+    struct CacheEntry* next_in_bucket;
+    struct CacheEntry* newer;
+    struct CacheEntry* older;
+} CacheEntry;
+
+/**
+*   Cache of computed distributions, shared across all lines of a session.
+*   Holds at most "capacity" bytes, evicting the least recently used entries first
+*   (a capacity of 0 disables the cache).
+*/
+typedef struct DistributionCache
+{
+    CacheEntry** buckets;
+    int bucket_count;
+    int entry_count;
+
+    CacheEntry* newest;
+    CacheEntry* oldest;
+
+    size_t bytes;
+    size_t capacity;
+
+    long hits;
+    long misses;
+} DistributionCache;
+
+#define DEFAULT_CACHE_CAPACITY (64 * 1024 * 1024)
+
+/**
+*   Operations measured by the statistics (see recordStat).
+*/
+typedef enum { STAT_ADD, STAT_TIMES, STAT_DICE, STAT_ROLL, STAT_ALLOC, STAT_KIND_COUNT } StatKind;
+
+/**
+*   Measurements of one kind of operation: the number of calls, their cumulative time
+*   (including nested operations, e.g. the additions of dice) and the number of
+*   element operations (multiplied pairs, FFT butterflies, rolls, allocated values;
+*   for dice the ones of their additions and the samples of estimates).
+*/
+typedef struct OperatorStats
+{
+    long calls;
+    double seconds;
+    double elements;
+} OperatorStats;
+
+/**
+*   Statistics of a statement or a whole session, collected if enabled (--stats).
+*   "largest_size" is the size of the largest distribution created,
+*   "peak_bytes" the largest amount of buffer memory in use at the same time.
+*/
+typedef struct Statistics
+{
+    OperatorStats operators[STAT_KIND_COUNT];
+    int largest_size;
+    size_t peak_bytes;
+} Statistics;
+
+/**
+*   How results are printed:
+*   OUTPUT_VERBOSE prints the distribution, the result and the diagnostics of every statement,
+*   OUTPUT_QUIET only the results (one per line),
+*   OUTPUT_CSV and OUTPUT_JSON one record per statement (or per value, see OutputWriter).
+*/
+typedef enum { OUTPUT_VERBOSE, OUTPUT_QUIET, OUTPUT_CSV, OUTPUT_JSON } OutputMode;
+
+/**
+*   Size of the output buffer, it is written to the stream when full.
+*/
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)
+
+/**
+*   Buffered writer for all output of a context, collecting many small writes into one
+*   large write to the stream "out".
+*
+*   If "with_distribution" is set, the structured modes include the probability of
+*   every value. If "interactive" is set (stdin is a TTY), a prompt is shown and the
+*   output is flushed after every statement.
+*/
+typedef struct OutputWriter
+{
+    FILE* out;
+    char* buffer;
+    size_t used;
+
+    OutputMode mode;
+    bool with_distribution;
+    bool interactive;
+    long statement_number;
+} OutputWriter;
+
+/**
+*   How the dice of a statement were computed: ENGINE_DIRECT without dice with uncertain
+*   operands, ENGINE_MIXTURE if such dice were computed exactly, ENGINE_MONTE_CARLO if any
+*   of them was estimated by sampling, ENGINE_APPROXIMATION if some of the sampled sums
+*   were drawn from the normal approximation (see MONTE_CARLO_ROLLED_DICE).
+*/
+typedef enum { ENGINE_DIRECT, ENGINE_MIXTURE, ENGINE_MONTE_CARLO, ENGINE_APPROXIMATION } Engine;
+
+/**
+*   Default budget of the exact computation of dice with uncertain operands.
+*/
+#define DEFAULT_EXACT_BYTES ((size_t) 256 * 1024 * 1024)
+#define DEFAULT_EXACT_OPERATIONS 1e9
+
+/**
+*   Default number of samples of the Monte Carlo estimator.
+*/
+#define DEFAULT_MONTE_CARLO_SAMPLES 1000000
+
+/**
+*   All state of an evaluation, so several evaluations can run independently
+*   (e.g. on different threads, see the batch mode in calc.l).
+*
+*   The member "active_distribution_count" keeps track of active distributions.
+*   A warning is displayed if a distribution remains after a statement is done
+*   (indicates a memory leak).
+*
+*   The member "output" buffers all output of the evaluation (see OutputWriter).
+*   The cache counters are printed with every result if "report_cache" is set.
+*
+*   If "collect_stats" is set, the operations of the current statement are measured in
+*   "statement_stats" and added up in "session_stats" after the statement is done.
+*
+*   Dice with uncertain operands are computed exactly while they stay within "exact_bytes"
+*   and "exact_operations", otherwise estimated from "monte_carlo_samples" samples on
+*   "monte_carlo_threads" threads. "statement_engine" and "statement_samples" record which
+*   engine the current statement used (the smallest number of samples of its estimates).
+*   "statement_failed" is set if an operation of the current statement could not be
+*   computed (see failStatement).
+*/
+struct EvalContext
+{
+    int active_distribution_count;
+    bool report_cache;
+
+    bool collect_stats;
+    Statistics statement_stats;
+    Statistics session_stats;
+
+    DistributionArena distribution_arena;
+    BufferPool buffer_pool;
+    DistributionCache distribution_cache;
+    RandomState random_state;
+
+    size_t exact_bytes;
+    double exact_operations;
+    long monte_carlo_samples;
+    int monte_carlo_threads;
+    Engine statement_engine;
+    long statement_samples;
+    long monte_carlo_runs;
+    bool statement_failed;
+
+    OutputWriter output;
+};
+
+/**
+*   Creates a new context writing to out, with an empty cache of the default capacity.
+*   (The random number generator still has to be seeded, see seedRandom.)
+*/
+EvalContext* createContext(FILE* out);
+
+/**
+*   Frees a context with everything it still holds (cache, arena, pool).
+*/
+void deleteContext(EvalContext* ctx);
+
+/**
+*   Redirects the output of the context (after flushing the pending output).
+*/
+void setOutput(EvalContext* ctx, FILE* out);
+
+/**
+*   Returns the output mode with the given name ("verbose", "quiet", "csv", "json"), -1 if there is none.
+*/
+int parseOutputMode(const char* name);
+
+/**
+*   Sets how results are printed, and whether stdin is a TTY.
+*/
+void setOutputMode(EvalContext* ctx, OutputMode mode, bool with_distribution, bool interactive);
+
+/**
+*   Sets the number of the next statement (statements are numbered from 1).
+*/
+void setStatementNumber(EvalContext* ctx, long number);
+
+/**
+*   Writes formatted text to the output buffer.
+*/
+void writeOutput(EvalContext* ctx, const char* format, ...);
+
+/**
+*   Writes the buffered output to the stream.
+*/
+void flushOutput(EvalContext* ctx);
+
+/**
+*   Prints the header of the structured output modes (the CSV columns).
+*/
+void printHeader(EvalContext* ctx);
+
+/**
+*   Prints the prompt for the next expression, if interactive.
+*/
+void printPrompt(EvalContext* ctx);
+
+/**
+*   Prints the result of a statement, with the distribution it was rolled from, in the output mode.
+*/
+void printResult(EvalContext* ctx, Distribution* dist, double result);
+
+/**
+*   Returns the half width of the 95% confidence interval of a probability estimated from samples.
+*/
+double getConfidence(double probability, long samples);
+
+/**
+*   Enables or disables printing the cache counters with every result.
+*/
+void setCacheReport(EvalContext* ctx, bool report);
+
+/**
+*   Adds the cache hits and misses of the context to the given counters.
+*/
+void getCacheCounters(EvalContext* ctx, long* hits, long* misses);
+
+/**
+*   Sets the budget of the exact computation of dice with uncertain operands
+*   (a negative value keeps the current bytes or operations).
+*/
+void setExactBudget(EvalContext* ctx, double bytes, double operations);
+
+/**
+*   Sets the number of samples and threads (0: all cores) of the Monte Carlo estimator.
+*/
+void setMonteCarlo(EvalContext* ctx, long samples, int threads);
+
+/**
+*   Enables or disables collecting statistics.
+*/
+void setStatistics(EvalContext* ctx, bool collect);
+
+/**
+*   Returns the current time in seconds if statistics are collected, 0 otherwise.
+*/
+double startStat(EvalContext* ctx);
+
+/**
+*   Records a call of the given kind, started at start (0: not timed), with the number of element operations.
+*/
+void recordStat(EvalContext* ctx, StatKind kind, double start, double elements);
+
+/**
+*   Prints the statistics of the finished statement and adds them to the session.
+*/
+void reportStatistics(EvalContext* ctx);
+
+/**
+*   Prints the given statistics as a table with a title.
+*/
+void printStatistics(EvalContext* ctx, Statistics* stats, const char* title);
+
+/**
+*   Prints the statistics of the whole session.
+*/
+void printSessionStatistics(EvalContext* ctx);
+
+/**
+*   Adds the session statistics of "from" to the ones of "into" (e.g. to sum up several workers).
+*/
+void mergeSessionStatistics(EvalContext* into, EvalContext* from);
+
+/**
+*   Returns the number of allocated distributions, the size of the largest one and the
+*   peak buffer memory of the session.
+*/
+void getSessionSizes(EvalContext* ctx, long* allocations, int* largest_size, size_t* peak_bytes);
+
+/**
+*   Writes a diagnostic message to the output of the context (used by the scanner),
+*   only in the verbose mode.
+*/
+void printMessage(EvalContext* ctx, const char* message);
+
+/**
+*   Writes an error message or another diagnostic (like the statistics): to the output
+*   in the verbose mode, to stderr otherwise (so structured output stays parseable).
+*/
+void printError(EvalContext* ctx, const char* message);
+
+/**
+*   Prints the error and marks the current statement as failed: its operations go on with
+*   placeholder results (which are not cached), then the statement ends like a syntax error
+*   instead of printing a result.
+*/
+void failStatement(EvalContext* ctx, const char* message);
+
+/**
+*   Sets the memory cap of the cache in bytes, evicting entries if necessary.
+*/
+void setCacheCapacity(EvalContext* ctx, size_t capacity);
+
+/**
+*   Returns a copy of the cached result, NULL if there is none.
+*/
+Distribution* cacheLookup(EvalContext* ctx, Operator op, unsigned long long key, unsigned long long key_1, unsigned long long key_2);
+
+/**
+*   Stores a copy of the result in the cache.
+*/
+void cacheStore(EvalContext* ctx, Operator op, unsigned long long key, unsigned long long key_1, unsigned long long key_2, Distribution* result);
+
+/**
+*   Evicts the least recently used entries until the cache fits into the given size.
+*/
+void cacheEvict(EvalContext* ctx, size_t limit);
+
+
+%}
+
+
+%code requires {
+  struct EvalContext;
+  struct Expression;
+}
+
+%define api.pure full
+%parse-param {void* scanner} {struct EvalContext* ctx}
+%lex-param {void* scanner}
+
+%union {
+  double f;
+  int i;
+  struct Distribution * d;
+  struct Expression * e;
+}
+
+%{
+int yylex(YYSTYPE* lvalp, void* scanner);
+%}
+
+%token INTEGER DOUBLE
+%token ROLL AVG VAR STDDEV PROB SEPERATOR
+%token PLUS TIMES DICE
+%token BRACKET_OPEN BRACKET_CLOSE EOL
+
+%type <f> DOUBLE line
+%type <i> INTEGER
+
+%type <e> expr mult dice term function
+
+%destructor { deleteExpression(ctx, $$); } <e>
+
+%start syntax
+
+%%
+
+syntax: syntax line EOL | line EOL;
+
+line: 
+  expr {
+    Distribution * dist = materialize(ctx, $1);
+    deleteExpression(ctx, $1);
+    if(ctx->statement_failed){
+      deleteDistribution(ctx, dist);
+      reportStatistics(ctx);
+      releaseStatement(ctx);
+      ctx->statement_failed = false;
+      ctx->statement_engine = ENGINE_DIRECT;
+      ctx->statement_samples = 0;
+      YYABORT;
+    }
+    double result = resolve(ctx, dist); 
+    $$ = result; 
+    printResult(ctx, dist, result);
+    deleteDistribution(ctx, dist);
+
+    reportStatistics(ctx);
+    releaseStatement(ctx);
+  }
+;
+
+expr: 
+  expr PLUS mult {$$ = createExpression(ctx, EXPR_ADD, $1, $3, 0);}
+| mult
+;
+
+mult:
+  mult TIMES dice {$$ = createExpression(ctx, EXPR_TIMES, $1, $3, 0);}
+| dice
+;
+
+dice:
+  dice DICE dice {$$ = createExpression(ctx, EXPR_DICE, $1, $3, 0);}
+| DICE dice {
+    Expression* count = createExpression(ctx, EXPR_VALUE, NULL, NULL, 1); 
+    $$ = createExpression(ctx, EXPR_DICE, count, $2, 0);
+  }
+| term
+;
+
+term:
+  INTEGER {$$ = createExpression(ctx, EXPR_VALUE, NULL, NULL, $1);}
+| DOUBLE {$$ = createExpression(ctx, EXPR_VALUE, NULL, NULL, $1);}
+| BRACKET_OPEN expr BRACKET_CLOSE {$$ = $2;}
+| function
+;
+
+function:
+  ROLL BRACKET_OPEN expr BRACKET_CLOSE {$$ = createExpression(ctx, EXPR_ROLL, $3, NULL, 0);}
+| ROLL BRACKET_OPEN expr SEPERATOR expr BRACKET_CLOSE {$$ = createExpression(ctx, EXPR_ROLL_MANY, $3, $5, 0);}
+| AVG BRACKET_OPEN expr BRACKET_CLOSE {$$ = createExpression(ctx, EXPR_AVG, $3, NULL, 0);}
+| VAR BRACKET_OPEN expr BRACKET_CLOSE {$$ = createExpression(ctx, EXPR_VAR, $3, NULL, 0);}
+| STDDEV BRACKET_OPEN expr BRACKET_CLOSE {$$ = createExpression(ctx, EXPR_STDDEV, $3, NULL, 0);}
+| PROB BRACKET_OPEN expr SEPERATOR expr BRACKET_CLOSE {$$ = createExpression(ctx, EXPR_PROB, $3, $5, 0);}
+;
+
+%%
+
+EvalContext* createContext(FILE* out){
+  EvalContext * ctx = (EvalContext *) calloc(1, sizeof(EvalContext));
+  ctx->distribution_cache.capacity = DEFAULT_CACHE_CAPACITY;
+  ctx->report_cache = true;
+  ctx->exact_bytes = DEFAULT_EXACT_BYTES;
+  ctx->exact_operations = DEFAULT_EXACT_OPERATIONS;
+  ctx->monte_carlo_samples = DEFAULT_MONTE_CARLO_SAMPLES;
+  ctx->monte_carlo_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  ctx->output.out = out;
+  ctx->output.buffer = (char *) malloc(OUTPUT_BUFFER_SIZE);
+  ctx->output.statement_number = 1;
+  return ctx;
+}
+
+
+void deleteContext(EvalContext* ctx){
+  releaseStatement(ctx);
+  flushOutput(ctx);
+  free(ctx->output.buffer);
+  cacheEvict(ctx, 0);
+  free(ctx->distribution_cache.buckets);
+  ArenaChunk * chunk = ctx->distribution_arena.first;
+  while(chunk != NULL){
+    ArenaChunk * next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  for(int size_class = 0x0; size_class < POOL_CLASS_COUNT; ++size_class){
+    while(ctx->buffer_pool.free_buffers[size_class] != NULL){
+      double * buffer = ctx->buffer_pool.free_buffers[size_class];
+      ctx->buffer_pool.free_buffers[size_class] = *(double **) buffer;
+      free(buffer);
+    }
+  }
+  free(ctx);
+}
+
+
+void setOutput(EvalContext* ctx, FILE* out){
+  flushOutput(ctx);
+  ctx->output.out = out;
+}
+
+
+int parseOutputMode(const char* name){
+  static const char * names[] = { "verbose", "quiet", "csv", "json" };
+  for(int mode = 0x0; mode < 4; ++mode){
+    if(strcmp(name, names[mode]) == 0) return mode;
+  }
+  return -1;
+}
+
+
+void setOutputMode(EvalContext* ctx, OutputMode mode, bool with_distribution, bool interactive){
+  ctx->output.mode = mode;
+  ctx->output.with_distribution = with_distribution;
+  ctx->output.interactive = interactive;
+}
+
+
+void setStatementNumber(EvalContext* ctx, long number){
+  ctx->output.statement_number = number;
+}
+
+
+void writeOutput(EvalContext* ctx, const char* format, ...){
+  OutputWriter * output = &ctx->output;
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(output->buffer + output->used, OUTPUT_BUFFER_SIZE - output->used, format, args);
+  va_end(args);
+  if(length < 0) return;
+  if(output->used + length < OUTPUT_BUFFER_SIZE){
+    output->used += length;
+    return;
+  }
+  // did not fit: make room and format again (a longer text bypasses the buffer)
+  flushOutput(ctx);
+  va_start(args, format);
+  if(length < OUTPUT_BUFFER_SIZE){
+    output->used = vsnprintf(output->buffer, OUTPUT_BUFFER_SIZE, format, args);
+  }else if(output->out != NULL){
+    vfprintf(output->out, format, args);
+  }
+  va_end(args);
+}
+
+
+void flushOutput(EvalContext* ctx){
+  OutputWriter * output = &ctx->output;
+  if(output->used > 0x0 && output->out != NULL){
+    fwrite(output->buffer, 1, output->used, output->out);
+    if(output->interactive) fflush(output->out);
+  }
+  output->used = 0;
+}
+
+
+void setCacheReport(EvalContext* ctx, bool report){
+  ctx->report_cache = report;
+}
+
+
+void getCacheCounters(EvalContext* ctx, long* hits, long* misses){
+  *hits += ctx->distribution_cache.hits;
+  *misses += ctx->distribution_cache.misses;
+}
+
+
+void setExactBudget(EvalContext* ctx, double bytes, double operations){
+  if(bytes >= 0) ctx->exact_bytes = bytes;
+  if(operations >= 0) ctx->exact_operations = operations;
+}
+
+
+void setMonteCarlo(EvalContext* ctx, long samples, int threads){
+  ctx->monte_carlo_samples = samples > 0 ? samples : DEFAULT_MONTE_CARLO_SAMPLES;
+  ctx->monte_carlo_threads = threads > 0 ? threads : sysconf(_SC_NPROCESSORS_ONLN);
+  if(ctx->monte_carlo_threads < 1) ctx->monte_carlo_threads = 1;
+}
+
+
+void setStatistics(EvalContext* ctx, bool collect){
+  ctx->collect_stats = collect;
+}
+
+
+double startStat(EvalContext* ctx){
+  if(!ctx->collect_stats) return 0;
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+
+void recordStat(EvalContext* ctx, StatKind kind, double start, double elements){
+  if(!ctx->collect_stats) return;
+  OperatorStats * stats = &ctx->statement_stats.operators[kind];
+  stats->calls++;
+  stats->elements += elements;
+  if(start > 0) stats->seconds += startStat(ctx) - start;
+  if(kind == STAT_ALLOC && elements > ctx->statement_stats.largest_size){
+    ctx->statement_stats.largest_size = elements;
+  }
+}
+
+
+void reportStatistics(EvalContext* ctx){
+  if(!ctx->collect_stats) return;
+  printStatistics(ctx, &ctx->statement_stats, "STATEMENT");
+  for(int kind = 0x0; kind < STAT_KIND_COUNT; ++kind){
+    ctx->session_stats.operators[kind].calls += ctx->statement_stats.operators[kind].calls;
+    ctx->session_stats.operators[kind].seconds += ctx->statement_stats.operators[kind].seconds;
+    ctx->session_stats.operators[kind].elements += ctx->statement_stats.operators[kind].elements;
+  }
+  if(ctx->statement_stats.largest_size > ctx->session_stats.largest_size){
+    ctx->session_stats.largest_size = ctx->statement_stats.largest_size;
+  }
+  if(ctx->statement_stats.peak_bytes > ctx->session_stats.peak_bytes){
+    ctx->session_stats.peak_bytes = ctx->statement_stats.peak_bytes;
+  }
+  memset(&ctx->statement_stats, 0, sizeof(Statistics));
+}
+
+
+void printStatistics(EvalContext* ctx, Statistics* stats, const char* title){
+  static const char * names[STAT_KIND_COUNT] = { "add", "times", "dice", "roll", "alloc" };
+  // the table is written at once, so the tables of batch workers do not interleave on stderr
+  char table[1024];
+  int used = snprintf(table, sizeof(table), "STATS (%s): %12s %14s %16s\n", title, "calls", "time [ms]", "elements");
+  for(int kind = 0x0; kind < STAT_KIND_COUNT; ++kind){
+    OperatorStats * op = &stats->operators[kind];
+    if(kind == STAT_ALLOC){
+      used += snprintf(table + used, sizeof(table) - used, "  %-10s %12ld %14s %16.0f\n", names[kind], op->calls, "-", op->elements);
+    }else{
+      used += snprintf(table + used, sizeof(table) - used, "  %-10s %12ld %14.3f %16.0f\n",
+                       names[kind], op->calls, op->seconds * 1000, op->elements);
+    }
+  }
+  snprintf(table + used, sizeof(table) - used, "  largest distribution: %d values, peak buffer memory: %zu KB\n",
+           stats->largest_size, stats->peak_bytes / 1024);
+  printError(ctx, table);
+}
+
+
+void printSessionStatistics(EvalContext* ctx){
+  if(!ctx->collect_stats) return;
+  printStatistics(ctx, &ctx->session_stats, "SESSION");
+}
+
+
+void mergeSessionStatistics(EvalContext* into, EvalContext* from){
+  for(int kind = 0x0; kind < STAT_KIND_COUNT; ++kind){
+    into->session_stats.operators[kind].calls += from->session_stats.operators[kind].calls;
+    into->session_stats.operators[kind].seconds += from->session_stats.operators[kind].seconds;
+    into->session_stats.operators[kind].elements += from->session_stats.operators[kind].elements;
+  }
+  if(from->session_stats.largest_size > into->session_stats.largest_size){
+    into->session_stats.largest_size = from->session_stats.largest_size;
+  }
+  if(from->session_stats.peak_bytes > into->session_stats.peak_bytes){
+    into->session_stats.peak_bytes = from->session_stats.peak_bytes;
+  }
+}
+
+
+void getSessionSizes(EvalContext* ctx, long* allocations, int* largest_size, size_t* peak_bytes){
+  *allocations = ctx->session_stats.operators[STAT_ALLOC].calls;
+  *largest_size = ctx->session_stats.largest_size;
+  *peak_bytes = ctx->session_stats.peak_bytes;
+}
+
+
+void printMessage(EvalContext* ctx, const char* message){
+  if(ctx->output.mode == OUTPUT_VERBOSE) writeOutput(ctx, "%s", message);
+}
+
+
+void printError(EvalContext* ctx, const char* message){
+  if(ctx->output.mode == OUTPUT_VERBOSE){
+    writeOutput(ctx, "%s", message);
+  }else{
+    flushOutput(ctx);
+    if(ctx->output.out != NULL) fflush(ctx->output.out);
+    fputs(message, stderr);
+  }
+}
+
+
+void failStatement(EvalContext* ctx, const char* message){
+  if(!ctx->statement_failed) printError(ctx, message);
+  ctx->statement_failed = true;
+}
+
+
+void printHeader(EvalContext* ctx){
+  if(ctx->output.mode != OUTPUT_CSV) return;
+  if(ctx->output.with_distribution){
+    writeOutput(ctx, "statement,result,engine,value,probability,confidence\n");
+  }else{
+    writeOutput(ctx, "statement,result,engine\n");
+  }
+}
+
+
+void printPrompt(EvalContext* ctx){
+  if(!ctx->output.interactive) return;
+  if(ctx->output.mode == OUTPUT_VERBOSE) writeOutput(ctx, "Enter new Expression:\n");
+  flushOutput(ctx);
+}
+
+
+void printResult(EvalContext* ctx, Distribution* dist, double result){
+  OutputWriter * output = &ctx->output;
+  long number = output->statement_number++;
+  double totalWeight = getTotalWeight(dist);
+  bool estimated = ctx->statement_engine >= ENGINE_MONTE_CARLO;
+  // approximated sums have no confidence interval to report
+  bool bounded = ctx->statement_engine == ENGINE_MONTE_CARLO;
+  const char * engine = estimated ? "monte carlo" : "exact";
+  switch(output->mode){
+  case OUTPUT_VERBOSE:
+    print(ctx, dist);
+    writeOutput(ctx, "--------------------\n"); 
+    writeOutput(ctx, "RESULT: %f\n", result); 
+    if(ctx->statement_engine == ENGINE_MIXTURE) writeOutput(ctx, "ENGINE: exact\n");
+    if(bounded){
+      writeOutput(ctx, "ENGINE: monte carlo, %ld samples (95%% confidence interval of every probability within +-%g)\n",
+                  ctx->statement_samples, getConfidence(0.5, ctx->statement_samples));
+    }else if(estimated){
+      writeOutput(ctx, "ENGINE: monte carlo, %ld samples (sums of more than %d dice drawn from the normal approximation, no confidence interval)\n",
+                  ctx->statement_samples, MONTE_CARLO_ROLLED_DICE);
+    }
+    if(ctx->active_distribution_count > 0x1) writeOutput(ctx, "WARNING: Leaking distributions: %d\n", ctx->active_distribution_count - 1);
+    if(ctx->report_cache && ctx->distribution_cache.hits + ctx->distribution_cache.misses > 0x0){
+      writeOutput(ctx, "CACHE: %ld hits, %ld misses\n", ctx->distribution_cache.hits, ctx->distribution_cache.misses);
+    }
+    writeOutput(ctx, "--------------------\n"); 
+    break;
+  case OUTPUT_QUIET:
+    writeOutput(ctx, "%.17g\n", result);
+    break;
+  case OUTPUT_CSV:
+    if(!output->with_distribution){
+      writeOutput(ctx, "%ld,%.17g,%s\n", number, result, engine);
+    }else if(!isUncertain(dist)){
+      writeOutput(ctx, bounded || !estimated ? "%ld,%.17g,%s,%.17g,1,0\n" : "%ld,%.17g,%s,%.17g,1,\n",
+                  number, result, engine, dist->constant);
+    }else{
+      for(int i = 0x0; i < dist->size; ++i){
+        if(dist->distribution[i] == 0) continue;
+        double probability = dist->distribution[i] / totalWeight;
+        writeOutput(ctx, "%ld,%.17g,%s,%.17g,%.17g,", number, result, engine, getValue(dist, i), probability);
+        if(bounded || !estimated) writeOutput(ctx, "%.17g", bounded ? getConfidence(probability, ctx->statement_samples) : 0);
+        writeOutput(ctx, "\n");
+      }
+    }
+    break;
+  case OUTPUT_JSON:
+    writeOutput(ctx, "{\"statement\":%ld,\"result\":%.17g,\"engine\":\"%s\"", number, result, engine);
+    if(estimated) writeOutput(ctx, ",\"samples\":%ld", ctx->statement_samples);
+    if(output->with_distribution){
+      // sampled probabilities come with the half width of their confidence interval, unless approximated
+      writeOutput(ctx, ",\"distribution\":[");
+      if(!isUncertain(dist)){
+        writeOutput(ctx, bounded ? "[%.17g,1,0]" : "[%.17g,1]", dist->constant);
+      }else{
+        bool first = true;
+        for(int i = 0x0; i < dist->size; ++i){
+          if(dist->distribution[i] == 0) continue;
+          double probability = dist->distribution[i] / totalWeight;
+          writeOutput(ctx, first ? "[%.17g,%.17g" : ",[%.17g,%.17g", getValue(dist, i), probability);
+          if(bounded) writeOutput(ctx, ",%.17g", getConfidence(probability, ctx->statement_samples));
+          writeOutput(ctx, "]");
+          first = false;
+        }
+      }
+      writeOutput(ctx, "]");
+    }
+    writeOutput(ctx, "}\n");
+    break;
+  }
+  ctx->statement_engine = ENGINE_DIRECT;
+  ctx->statement_samples = 0;
+  printPrompt(ctx);
+}
+
+
+double getConfidence(double probability, long samples){
+  return 1.96 * sqrt(probability * (1 - probability) / samples);
+}
+
+Distribution * createDistribution(EvalContext* ctx, int size, double initVal, double constant){
+  DistributionArena * arena = &ctx->distribution_arena;
+  Distribution * newDist;
+  if(arena->free_list != NULL){
+    newDist = arena->free_list;
+    arena->free_list = newDist->next_free;
+  }else{
+    if(arena->current == NULL || arena->used == ARENA_CHUNK_SIZE){
+      ArenaChunk * next = arena->current == NULL ? arena->first : arena->current->next;
+      if(next == NULL){
+        next = (ArenaChunk *) malloc(sizeof(ArenaChunk));
+        next->next = NULL;
+        if(arena->current == NULL) arena->first = next;
+        else arena->current->next = next;
+      }
+      arena->current = next;
+      arena->used = 0;
+    }
+    newDist = &arena->current->distributions[arena->used++];
+  }
+  //printf("New Distribution [%ld]: Size: %d, InitVal: %f, Constant: %f\n", (long)newDist, size, initVal, constant);
+  newDist->size = size;
+  newDist->constant = constant;
+  newDist->offset = 0x1;
+  newDist->values = NULL;
+  newDist->sampler = NULL;
+  newDist->key = 0;
+  newDist->next_free = NULL;
+  if (size > 0x0){
+    newDist->distribution = acquireBuffer(ctx, size);
+    if(initVal == 0){
+      memset(newDist->distribution, 0, sizeof(double) * size);
+    }else{
+      for(int i = 0x0; i < size; ++i){
+        newDist->distribution[i] = initVal;
+      }
+    }
+  }else{
+    newDist->distribution = NULL;
+  }
+  //print(newDist);
+  ctx->active_distribution_count++;
+  recordStat(ctx, STAT_ALLOC, 0, size);
+  return newDist;
+}
+
+
+void deleteDistribution(EvalContext* ctx, Distribution * dist){
+  //printf("deleting %ld\n", (long)dist);
+  if(dist->distribution != 0){
+    releaseBuffer(ctx, dist->distribution, dist->size);
+    dist->distribution = NULL;
+  }
+  if(dist->values != NULL){
+    releaseBuffer(ctx, dist->values, dist->size);
+    dist->values = NULL;
+  }
+  if(dist->sampler != NULL){
+    deleteSampler(dist->sampler);
+    dist->sampler = NULL;
+  }
+  dist->next_free = ctx->distribution_arena.free_list;
+  ctx->distribution_arena.free_list = dist;
+  ctx->active_distribution_count--;
+  //printf("Remaining active distributions: %d\n", ctx->active_distribution_count);
+}
+
+
+int getSizeClass(int size){
+  int size_class = 0;
+  while((1 << size_class) < size) size_class++;
+  return size_class;
+}
+
+
+double* acquireBuffer(EvalContext* ctx, int size){
+  int size_class = getSizeClass(size);
+  ctx->buffer_pool.used_bytes += sizeof(double) << size_class;
+  if(ctx->collect_stats && ctx->buffer_pool.used_bytes > ctx->statement_stats.peak_bytes){
+    ctx->statement_stats.peak_bytes = ctx->buffer_pool.used_bytes;
+  }
+  double * buffer = ctx->buffer_pool.free_buffers[size_class];
+  if(buffer != NULL){
+    ctx->buffer_pool.free_buffers[size_class] = *(double **) buffer;
+    ctx->buffer_pool.retained_bytes -= sizeof(double) << size_class;
+    return buffer;
+  }
+  return (double*) malloc(sizeof(double) << size_class);
+}
+
+
+void releaseBuffer(EvalContext* ctx, double* buffer, int size){
+  int size_class = getSizeClass(size);
+  *(double **) buffer = ctx->buffer_pool.free_buffers[size_class];
+  ctx->buffer_pool.free_buffers[size_class] = buffer;
+  ctx->buffer_pool.retained_bytes += sizeof(double) << size_class;
+  ctx->buffer_pool.used_bytes -= sizeof(double) << size_class;
+}
+
+
+void releaseStatement(EvalContext* ctx){
+  DistributionArena * arena = &ctx->distribution_arena;
+  int handed_out = 0;
+  for(ArenaChunk * chunk = arena->first; chunk != NULL && arena->current != NULL; chunk = chunk->next){
+    int used = chunk == arena->current ? arena->used : ARENA_CHUNK_SIZE;
+    for(int i = 0x0; i < used; ++i){
+      // deleted distributions have already given back their buffer and sampler
+      Distribution * dist = &chunk->distributions[i];
+      if(dist->distribution != NULL) releaseBuffer(ctx, dist->distribution, dist->size);
+      if(dist->values != NULL) releaseBuffer(ctx, dist->values, dist->size);
+      if(dist->sampler != NULL) deleteSampler(dist->sampler);
+      dist->distribution = NULL;
+      dist->values = NULL;
+      dist->sampler = NULL;
+    }
+    handed_out += used;
+    if(chunk == arena->current) break;
+  }
+  for(Distribution * dist = arena->free_list; dist != NULL; dist = dist->next_free){
+    handed_out--;
+  }
+  if(handed_out != ctx->active_distribution_count){
+    char message[96];
+    snprintf(message, sizeof(message), "WARNING: Arena holds %d distributions, counted %d\n", handed_out, ctx->active_distribution_count);
+    printError(ctx, message);
+  }
+  ctx->active_distribution_count = 0;
+  arena->current = NULL;
+  arena->used = 0;
+  arena->free_list = NULL;
+
+  // keep the small buffers, they are needed by nearly every statement
+  for(int size_class = POOL_CLASS_COUNT - 1; size_class >= 0 && ctx->buffer_pool.retained_bytes > POOL_RETAIN_LIMIT; size_class--){
+    while(ctx->buffer_pool.free_buffers[size_class] != NULL && ctx->buffer_pool.retained_bytes > POOL_RETAIN_LIMIT){
+      double * buffer = ctx->buffer_pool.free_buffers[size_class];
+      ctx->buffer_pool.free_buffers[size_class] = *(double **) buffer;
+      ctx->buffer_pool.retained_bytes -= sizeof(double) << size_class;
+      free(buffer);
+    }
+  }
+}
+
+
+Distribution * createSparseDistribution(EvalContext* ctx, int size, double constant){
+  Distribution * newDist = createDistribution(ctx, size, 0x0, constant);
+  newDist->offset = 0x0;
+  newDist->values = acquireBuffer(ctx, size);
+  return newDist;
+}
+
+
+Distribution * copyDistribution(EvalContext* ctx, Distribution * dist){
+  Distribution * newDist = createDistribution(ctx, dist->size, 0x0, dist->constant);
+  if(isUncertain(dist)){
+    memcpy(newDist->distribution, dist->distribution, sizeof(double) * dist->size);
+  }
+  if(isSparse(dist)){
+    newDist->values = acquireBuffer(ctx, dist->size);
+    memcpy(newDist->values, dist->values, sizeof(double) * dist->size);
+  }
+  newDist->offset = dist->offset;
+  newDist->key = dist->key;
+  return newDist;
+}
+
+
+bool isUncertain(Distribution * dist){
+  return dist->size > 0x0;
+}
+
+
+bool isSparse(Distribution * dist){
+  return dist->values != NULL;
+}
+
+
+bool isIntegral(Distribution * dist){
+  if(!isSparse(dist)) return true;
+  for(int i = 0x0; i < dist->size; ++i){
+    if(dist->values[i] != floor(dist->values[i])) return false;
+  }
+  return true;
+}
+
+
+bool canDensify(Distribution * dist){
+  if(!isSparse(dist)) return true;
+  return isIntegral(dist) && fabs(dist->values[0]) + fabs(dist->values[dist->size - 1]) < INT_MAX / 2;
+}
+
+
+double getValue(Distribution * dist, int index){
+  if(isSparse(dist)) return dist->constant + dist->values[index];
+  return dist->constant + dist->offset + index;
+}
+
+
+double getTotalWeight(Distribution * dist){
+  double totalWeight = 0;
+  for(int i = 0; i < dist->size; i++){
+    totalWeight += dist->distribution[i];
+  }
+  return totalWeight;
+}
+
+
+void print(EvalContext* ctx, Distribution * dist){
+  writeOutput(ctx, "----- PRINTING %ld -----\n", (long)dist);
+  if(isUncertain(dist)){
+    writeOutput(ctx, "Distribution: \n");
+    for(int i = 0; i < dist->size; ++i){
+      writeOutput(ctx, "%.15g: %.80f\n", getValue(dist, i), dist->distribution[i]);
+    }
+  }else{
+    writeOutput(ctx, "Constant: %f\n", dist->constant);
+  }
+  writeOutput(ctx, "--------------------\n");
+}
+
+
+
+double resolve(EvalContext* ctx, Distribution * d){
+  ///printf("resolving... \n");
+  double result = d->constant;
+  if(isUncertain(d)){
+    //print(d);
+    Distribution * dn = roll(ctx, d);
+    result = dn->constant;
+    deleteDistribution(ctx, dn);
+  }
+  return result;
+}
+
+
+Distribution * add(EvalContext* ctx, Distribution * d1, Distribution * d2){
+  ///printf("adding... \n");
+  double start = startStat(ctx);
+  if(!isUncertain(d1) || !isUncertain(d2)){
+    Distribution * d3 = copyDistribution(ctx, isUncertain(d1) ? d1 : d2);
+    d3->constant = d1->constant + d2->constant;
+    recordStat(ctx, STAT_ADD, start, d3->size);
+    return d3;
+  }
+
+  double weight1 = getTotalWeight(d1);
+  double weight2 = getTotalWeight(d2);
+  Distribution * dense1 = d1, * dense2 = d2;
+  if(isSparse(d1) || isSparse(d2)){
+    // convolving the dense forms costs about their combined range, adding all pairs their product
+    double range1 = isSparse(d1) ? d1->values[d1->size - 1] - d1->values[0] + 1 : d1->size;
+    double range2 = isSparse(d2) ? d2->values[d2->size - 1] - d2->values[0] + 1 : d2->size;
+    if(!canDensify(d1) || !canDensify(d2) || range1 + range2 > (double) d1->size * d2->size){
+      Distribution * d3 = combinePairs(ctx, d1, d2, false);
+      recordStat(ctx, STAT_ADD, start, (double) d1->size * d2->size);
+      return d3;
+    }
+    if(isSparse(d1)) dense1 = densify(ctx, d1);
+    if(isSparse(d2)) dense2 = densify(ctx, d2);
+  }
+
+  Distribution * d3 = createDistribution(ctx, dense1->size + dense2->size - 1, 0x0, d1->constant + d2->constant);
+  d3->offset = dense1->offset + dense2->offset;
+  double elements = convolve(ctx, dense1->distribution, dense1->size, 1 / weight1,
+                             dense2->distribution, dense2->size, 1 / weight2,
+                             d3->distribution);
+  if(dense1 != d1) deleteDistribution(ctx, dense1);
+  if(dense2 != d2) deleteDistribution(ctx, dense2);
+  
+  d3 = chooseForm(ctx, d3);
+  recordStat(ctx, STAT_ADD, start, elements);
+  return d3;
+}
+
+
+Distribution * chooseForm(EvalContext* ctx, Distribution * dist){
+  if(!isUncertain(dist)) return dist;
+  int first = 0x0, last = dist->size - 1, nonzero = 0x0;
+  for(int i = 0x0; i < dist->size; ++i){
+    if(dist->distribution[i] != 0) nonzero++;
+  }
+  if(nonzero == 0x0) return dist;
+  while(dist->distribution[first] == 0) first++;
+  while(dist->distribution[last] == 0) last--;
+
+  double range = isSparse(dist) ? dist->values[last] - dist->values[first] + 1 : last - first + 1;
+  bool sparse = nonzero < SPARSE_DENSITY * range || !canDensify(dist);
+
+  Distribution * result;
+  if(sparse){
+    if(isSparse(dist) && nonzero == dist->size) return dist;
+    result = createSparseDistribution(ctx, nonzero, dist->constant);
+    int k = 0x0;
+    for(int i = first; i <= last; ++i){
+      if(dist->distribution[i] == 0) continue;
+      result->values[k] = getValue(dist, i) - dist->constant;
+      result->distribution[k++] = dist->distribution[i];
+    }
+  }else{
+    if(!isSparse(dist) && first == 0x0 && last == dist->size - 1) return dist;
+    result = densify(ctx, dist);
+  }
+  result->key = dist->key;
+  deleteDistribution(ctx, dist);
+  return result;
+}
+
+
+Distribution * densify(EvalContext* ctx, Distribution * dist){
+  int first = 0x0, last = dist->size - 1;
+  while(first < last && dist->distribution[first] == 0) first++;
+  while(last > first && dist->distribution[last] == 0) last--;
+
+  double min = getValue(dist, first) - dist->constant;
+  Distribution * result = createDistribution(ctx, (int) (getValue(dist, last) - dist->constant - min) + 1, 0x0, dist->constant);
+  result->offset = (int) min;
+  for(int i = first; i <= last; ++i){
+    result->distribution[(int) (getValue(dist, i) - dist->constant - min)] += dist->distribution[i];
+  }
+  return result;
+}
+
+
+Distribution * collectValues(EvalContext* ctx, WeightedValue* pairs, int count, double constant){
+  qsort(pairs, count, sizeof(WeightedValue), compareValues);
+  int distinct = 0x0;
+  for(int i = 0x0; i < count; ++i){
+    if(distinct > 0x0 && fabs(pairs[i].value - pairs[distinct - 1].value) <= VALUE_EPSILON * fmax(1, fabs(pairs[i].value))){
+      pairs[distinct - 1].weight += pairs[i].weight;
+    }else{
+      pairs[distinct++] = pairs[i];
+    }
+  }
+
+  Distribution * result = createSparseDistribution(ctx, distinct, constant);
+  for(int i = 0x0; i < distinct; ++i){
+    result->values[i] = pairs[i].value;
+    result->distribution[i] = pairs[i].weight;
+  }
+  return chooseForm(ctx, result);
+}
+
+
+Distribution* combinePairs(EvalContext* ctx, Distribution* d1, Distribution* d2, bool multiply){
+  int size1 = isUncertain(d1) ? d1->size : 0x1;
+  int size2 = isUncertain(d2) ? d2->size : 0x1;
+  double weight1 = isUncertain(d1) ? getTotalWeight(d1) : 1;
+  double weight2 = isUncertain(d2) ? getTotalWeight(d2) : 1;
+  // sums are combined relative to the constants, products from the whole values
+  double constant = multiply ? 0 : d1->constant + d2->constant;
+  double * values1 = (double *) malloc(sizeof(double) * size1);
+  double * values2 = (double *) malloc(sizeof(double) * size2);
+  double * probabilities2 = (double *) malloc(sizeof(double) * size2);
+  bool integral = true;
+  for(int i = 0x0; i < size1; ++i){
+    values1[i] = isUncertain(d1) ? getValue(d1, i) : d1->constant;
+    if(!multiply) values1[i] -= d1->constant;
+    integral = integral && values1[i] == floor(values1[i]);
+  }
+  for(int j = 0x0; j < size2; ++j){
+    values2[j] = isUncertain(d2) ? getValue(d2, j) : d2->constant;
+    if(!multiply) values2[j] -= d2->constant;
+    probabilities2[j] = isUncertain(d2) ? d2->distribution[j] / weight2 : 1;
+    integral = integral && values2[j] == floor(values2[j]);
+  }
+
+  // the values are sorted, so the extreme results come from the extreme values
+  double min, max;
+  if(multiply){
+    double corners[4] = { values1[0] * values2[0], values1[0] * values2[size2 - 1],
+                          values1[size1 - 1] * values2[0], values1[size1 - 1] * values2[size2 - 1] };
+    min = fmin(fmin(corners[0], corners[1]), fmin(corners[2], corners[3]));
+    max = fmax(fmax(corners[0], corners[1]), fmax(corners[2], corners[3]));
+  }else{
+    min = values1[0] + values2[0];
+    max = values1[size1 - 1] + values2[size2 - 1];
+  }
+  integral = integral && fmax(fabs(min), fabs(max)) < ldexp(1, DBL_MANT_DIG);
+  double range = max - min + 1;
+
+  Distribution * d3 = NULL;
+  if(integral && range <= MAX_RESULT_CELLS && range <= PAIR_DENSE_FACTOR * (double) size1 * size2
+     && fabs(min) + fabs(max) < INT_MAX / 2){
+    d3 = createDistribution(ctx, (int) range, 0x0, constant);
+    d3->offset = (int) min;
+    double * cells = d3->distribution;
+    for(int i = 0x0; i < size1; ++i){
+      double p1 = isUncertain(d1) ? d1->distribution[i] / weight1 : 1;
+      if(p1 == 0) continue;
+      double value1 = values1[i];
+      if(multiply){
+        for(int j = 0x0; j < size2; ++j) cells[(int) (value1 * values2[j] - min)] += p1 * probabilities2[j];
+      }else{
+        for(int j = 0x0; j < size2; ++j) cells[(int) (value1 + values2[j] - min)] += p1 * probabilities2[j];
+      }
+    }
+    d3 = chooseForm(ctx, d3);
+  }else if(integral){
+    long long * keys = NULL;
+    double * weights = NULL;
+    int capacity = 0x0, count = 0x0;
+    bool complete = true;
+    for(int i = 0x0; i < size1 && complete; ++i){
+      double p1 = isUncertain(d1) ? d1->distribution[i] / weight1 : 1;
+      if(p1 == 0) continue;
+      for(int j = 0x0; j < size2 && complete; ++j){
+        if(probabilities2[j] == 0) continue;
+        double value = multiply ? values1[i] * values2[j] : values1[i] + values2[j];
+        complete = addToTable(&keys, &weights, &capacity, &count, (long long) value, p1 * probabilities2[j]);
+      }
+    }
+    WeightedValue * pairs = complete ? (WeightedValue *) malloc(sizeof(WeightedValue) * (count > 0x0 ? count : 0x1)) : NULL;
+    if(pairs != NULL){
+      int k = 0x0;
+      for(int slot = 0x0; slot < capacity; ++slot){
+        if(keys[slot] == LLONG_MIN) continue;
+        pairs[k].value = (double) keys[slot];
+        pairs[k++].weight = weights[slot];
+      }
+      d3 = collectValues(ctx, pairs, count, constant);
+      free(pairs);
+    }
+    free(keys);
+    free(weights);
+  }else{
+    double count = (double) size1 * size2;
+    WeightedValue * pairs = count <= INT_MAX ? (WeightedValue *) malloc(sizeof(WeightedValue) * (size_t) count) : NULL;
+    if(pairs != NULL){
+      int k = 0x0;
+      for(int i = 0x0; i < size1; ++i){
+        double p1 = isUncertain(d1) ? d1->distribution[i] / weight1 : 1;
+        if(p1 == 0) continue;
+        for(int j = 0x0; j < size2; ++j){
+          pairs[k].value = multiply ? values1[i] * values2[j] : values1[i] + values2[j];
+          pairs[k++].weight = p1 * probabilities2[j];
+        }
+      }
+      d3 = collectValues(ctx, pairs, k, constant);
+      free(pairs);
+      if(d3->size > MAX_RESULT_CELLS){
+        deleteDistribution(ctx, d3);
+        d3 = NULL;
+      }
+    }
+  }
+  free(values1);
+  free(values2);
+  free(probabilities2);
+
+  if(d3 == NULL){
+    char message[160];
+    snprintf(message, sizeof(message), "Too many values in the result: more than %d, Exiting!\n", MAX_RESULT_CELLS);
+    failStatement(ctx, message);
+    d3 = createDistribution(ctx, 0x0, 0x0, 0);
+  }
+  return d3;
+}
+
+
+bool addToTable(long long** keys, double** weights, int* capacity, int* count, long long key, double weight){
+  if(4 * (double) (*count + 1) > 3 * (double) *capacity){
+    if(*count >= MAX_RESULT_CELLS) return false;
+    int old_capacity = *capacity;
+    long long * old_keys = *keys;
+    double * old_weights = *weights;
+    int new_capacity = old_capacity == 0x0 ? 1024 : 2 * old_capacity;
+    long long * new_keys = (long long *) malloc(sizeof(long long) * new_capacity);
+    double * new_weights = (double *) malloc(sizeof(double) * new_capacity);
+    if(new_keys == NULL || new_weights == NULL){
+      free(new_keys);
+      free(new_weights);
+      return false;
+    }
+    for(int slot = 0x0; slot < new_capacity; ++slot) new_keys[slot] = LLONG_MIN;
+    *keys = new_keys;
+    *weights = new_weights;
+    *capacity = new_capacity;
+    *count = 0x0;
+    for(int slot = 0x0; slot < old_capacity; ++slot){
+      if(old_keys[slot] != LLONG_MIN) addToTable(keys, weights, capacity, count, old_keys[slot], old_weights[slot]);
+    }
+    free(old_keys);
+    free(old_weights);
+  }
+  int slot = (int) (mixBits((unsigned long long) key) & (unsigned long long) (*capacity - 1));
+  while((*keys)[slot] != LLONG_MIN && (*keys)[slot] != key) slot = (slot + 1) & (*capacity - 1);
+  if((*keys)[slot] == key){
+    (*weights)[slot] += weight;
+  }else{
+    (*keys)[slot] = key;
+    (*weights)[slot] = weight;
+    (*count)++;
+  }
+  return true;
+}
+
+
+int compareValues(const void* a, const void* b){
+  double value_a = ((const WeightedValue *) a)->value;
+  double value_b = ((const WeightedValue *) b)->value;
+  return (value_a > value_b) - (value_a < value_b);
+}
+
+
+double convolve(EvalContext* ctx, double* a, int size_a, double scale_a, double* b, int size_b, double scale_b, double* out){
+  int size_out = size_a + size_b - 1;
+  int n = 1, log_n = 0;
+  while(n < size_out){
+    n <<= 1;
+    log_n++;
+  }
+
+  if((double) size_a * size_b <= (double) CONVOLUTION_FFT_FACTOR * n * log_n){
+    for(int k = 0x0; k < size_out; ++k){
+      out[k] = 0;
+    }
+    for(int i = 0x0; i < size_a; ++i){
+      double weight = a[i] * scale_a * scale_b;
+      if(weight == 0) continue;
+      for(int j = 0x0; j < size_b; ++j){
+        out[i + j] += weight * b[j];
+      }
+    }
+    return (double) size_a * size_b;
+  }
+
+  double * re = acquireBuffer(ctx, n);
+  double * im = acquireBuffer(ctx, n);
+  char * resolved = (char *) malloc(size_out);
+  double operations = 0;
+
+  // cells no pair of non-zero operand cells reaches are exactly 0
+  int first_a = 0x0, last_a = size_a - 1, first_b = 0x0, last_b = size_b - 1, nonzero = 0x0;
+  while(first_a < last_a && a[first_a] == 0) first_a++;
+  while(last_a > first_a && a[last_a] == 0) last_a--;
+  while(first_b < last_b && b[first_b] == 0) first_b++;
+  while(last_b > first_b && b[last_b] == 0) last_b--;
+  for(int i = first_a; i <= last_a; ++i) nonzero += a[i] != 0;
+  for(int j = first_b; j <= last_b; ++j) nonzero += b[j] != 0;
+  if(nonzero == last_a - first_a + last_b - first_b + 2){
+    for(int k = 0x0; k < size_out; ++k){
+      resolved[k] = k < first_a + first_b || k > last_a + last_b;
+    }
+  }else{
+    // the operands have gaps: count the pairs reaching each cell
+    memset(re, 0, sizeof(double) * n);
+    memset(im, 0, sizeof(double) * n);
+    for(int i = 0x0; i < size_a; ++i) re[i] = a[i] != 0;
+    for(int j = 0x0; j < size_b; ++j) im[j] = b[j] != 0;
+    squareSpectrum(re, im, n);
+    operations += (double) n * log_n + n;
+    for(int k = 0x0; k < size_out; ++k){
+      resolved[k] = im[k] / (2.0 * n) < 0.5;
+    }
+  }
+  int unresolved = 0x0;
+  for(int k = 0x0; k < size_out; ++k){
+    if(resolved[k]) out[k] = 0;
+    else unresolved++;
+  }
+
+  double * log_a = acquireBuffer(ctx, size_a);
+  double * log_b = acquireBuffer(ctx, size_b);
+  for(int i = 0x0; i < size_a; ++i) log_a[i] = a[i] > 0 ? log(a[i] * scale_a) : -INFINITY;
+  for(int j = 0x0; j < size_b; ++j) log_b[j] = b[j] > 0 ? log(b[j] * scale_b) : -INFINITY;
+
+  // every pass transforms the operand cells reaching the cells [first, last]
+  double theta = 0;
+  int mode = -1, first = 0x0, last = size_out - 1;
+  bool aim = true;
+  for(int pass = 0x0; pass < CONVOLUTION_MAX_PASSES && unresolved > 0x0; ++pass){
+    int start_a = first - size_b + 1 > 0 ? first - size_b + 1 : 0;
+    int start_b = first - size_a + 1 > 0 ? first - size_a + 1 : 0;
+    int end_a = last < size_a - 1 ? last : size_a - 1;
+    int end_b = last < size_b - 1 ? last : size_b - 1;
+    trimTilted(log_a, theta, &start_a, &end_a);
+    trimTilted(log_b, theta, &start_b, &end_b);
+    int length = end_a - start_a + end_b - start_b + 1, origin = start_a + start_b;
+    int m = 1, log_m = 0;
+    while(m < length){
+      m <<= 1;
+      log_m++;
+    }
+    double shift = convolveTilted(log_a + start_a, end_a - start_a + 1, log_b + start_b, end_b - start_b + 1, theta, re, im, m);
+    operations += (double) m * log_m + m;
+    double peak = 0;
+    for(int k = 0x0; k < length; ++k){
+      if(im[k] > peak) peak = im[k];
+    }
+    double underflow = log(DBL_MIN) - log(CONVOLUTION_RELATIVE_BOUND * peak);
+    int found = 0x0;
+    for(int k = first; k <= last; ++k){
+      if(resolved[k]) continue;
+      double value = k >= origin && k < origin + length ? im[k - origin] : 0;
+      double exponent = shift - theta * (k - origin);
+      if(value >= CONVOLUTION_RELATIVE_BOUND * peak){
+        out[k] = value * exp(exponent);
+      }else if(exponent < underflow){
+        out[k] = 0; // below the smallest normal double
+      }else{
+        continue;
+      }
+      resolved[k] = 1;
+      found++;
+      if(mode < 0 || out[k] > out[mode]) mode = k;
+    }
+    unresolved -= found;
+    if(unresolved == 0x0 || mode < 0) break;
+    if(found == 0x0){
+      if(!aim) break;
+      aim = false; // aimed too far, leaving a gap: tilt to the edge itself
+    }else{
+      aim = true;
+    }
+
+    // the unresolved cells next to the mode, below it if there are any
+    int edge, next;
+    for(first = 0x0; first < mode && resolved[first]; ++first);
+    if(first < mode){
+      for(last = mode - 1; resolved[last]; --last);
+      edge = last + 1;
+      next = edge + 1;
+    }else{
+      for(last = size_out - 1; resolved[last]; --last);
+      for(first = mode + 1; resolved[first]; ++first);
+      edge = first - 1;
+      next = edge - 1;
+    }
+    if(next < 0x0 || next >= size_out || out[edge] <= 0 || out[next] <= 0) break;
+
+    // tilt the slope of the log at the edge to 0 (aim: at the distance the curvature of the
+    // log between the mode and the edge allows for one pass, so the tilted values fall below
+    // the bound there)
+    double slope = (log(out[next]) - log(out[edge])) / (next - edge);
+    int middle = (edge + mode) / 2;
+    if(aim && abs(middle - edge) > 0x0 && abs(middle - mode) > 0x0 && out[middle - 1] > 0 && out[middle + 1] > 0){
+      double curvature = (slope - (log(out[middle + 1]) - log(out[middle - 1])) / 2) / (edge - middle);
+      if(curvature < 0){
+        double distance = sqrt(2 * log(1 / CONVOLUTION_RELATIVE_BOUND) / -curvature);
+        slope -= curvature * (next > edge ? distance : -distance);
+      }
+    }
+    theta = -slope;
+  }
+
+  for(int k = 0x0; k < size_out && unresolved > 0x0; ++k){
+    if(resolved[k]) continue;
+    double sum = 0;
+    int first = k - size_b + 1 > 0 ? k - size_b + 1 : 0;
+    int last = k < size_a - 1 ? k : size_a - 1;
+    for(int i = first; i <= last; ++i){
+      sum += a[i] * b[k - i];
+    }
+    out[k] = sum * scale_a * scale_b;
+    operations += last - first + 1;
+  }
 
-%type <f> DOUBLE line
-%type <i> INTEGER
+  free(resolved);
+  releaseBuffer(ctx, log_a, size_a);
+  releaseBuffer(ctx, log_b, size_b);
+  releaseBuffer(ctx, re, n);
+  releaseBuffer(ctx, im, n);
+  return operations;
+}
 
-%type <d> expr mult dice term function
 
-%start syntax
+double convolveTilted(double* log_a, int size_a, double* log_b, int size_b, double theta, double* re, double* im, int n){
+  /*
+    Both operands are packed into one complex signal z = a + ib.
+    Since z*z = a*a - b*b + 2i(a*b), the imaginary part of the squared spectrum
+    transformed back is twice the wanted convolution, saving one forward transform.
+    The logs of the largest tilted values are subtracted to stay in the range of a double.
+  */
+  double max_a = -INFINITY, max_b = -INFINITY;
+  for(int i = 0x0; i < size_a; ++i) max_a = fmax(max_a, log_a[i] + theta * i);
+  for(int j = 0x0; j < size_b; ++j) max_b = fmax(max_b, log_b[j] + theta * j);
+  memset(re, 0, sizeof(double) * n);
+  memset(im, 0, sizeof(double) * n);
+  for(int i = 0x0; i < size_a; ++i) re[i] = exp(log_a[i] + theta * i - max_a);
+  for(int j = 0x0; j < size_b; ++j) im[j] = exp(log_b[j] + theta * j - max_b);
+  squareSpectrum(re, im, n);
+  for(int k = 0x0; k < n; ++k){
+    im[k] /= 2.0 * n;
+  }
+  return max_a + max_b;
+}
 
-%%
 
-syntax: syntax line EOL | line EOL;
+void trimTilted(double* log_a, double theta, int* first, int* last){
+  double max = -INFINITY;
+  for(int i = *first; i <= *last; ++i) max = fmax(max, log_a[i] + theta * i);
+  double bound = max + log(CONVOLUTION_OPERAND_BOUND);
+  while(*first < *last && !(log_a[*first] + theta * *first >= bound)) (*first)++;
+  while(*last > *first && !(log_a[*last] + theta * *last >= bound)) (*last)--;
+}
 
-line: 
-  expr {
-    double result = resolve($1); 
-    $$ = result; 
-    deleteDistribution($1);
 
-    printResult(result);
+void squareSpectrum(double* re, double* im, int n){
+  fft(re, im, n, false);
+  for(int k = 0x0; k < n; ++k){
+    double r = re[k], m = im[k];
+    re[k] = r * r - m * m;
+    im[k] = 2 * r * m;
   }
-;
+  fft(re, im, n, true);
+}
 
-expr: 
-  expr PLUS mult {
-    $$ = add($1, $3); 
-    deleteDistribution($1); 
-    deleteDistribution($3);
+
+void fft(double* re, double* im, int n, bool inverse){
+  // bit reversal permutation
+  for(int i = 0x1, j = 0x0; i < n; ++i){
+    int bit = n >> 1;
+    for(; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if(i < j){
+      double t = re[i]; re[i] = re[j]; re[j] = t;
+      t = im[i]; im[i] = im[j]; im[j] = t;
+    }
   }
-| mult
-;
 
-mult:
-  mult TIMES dice {
-    $$ = times($1, $3); 
-    deleteDistribution($1); 
-    deleteDistribution($3);
+  // twiddle factors are evaluated directly instead of recurrently to keep them exact,
+  // once for the longest stage: stage len uses every (n / len)-th of them
+  int half_n = n > 1 ? n >> 1 : 1;
+  double * w_re = (double *) malloc(sizeof(double) * half_n);
+  double * w_im = (double *) malloc(sizeof(double) * half_n);
+  double angle = (inverse ? 2 : -2) * M_PI / n;
+  for(int k = 0x0; k < half_n; ++k){
+    w_re[k] = cos(angle * k);
+    w_im[k] = sin(angle * k);
   }
-| dice
-;
 
-dice:
-  dice DICE dice {
-    $$ = dice($1, $3); 
-    deleteDistribution($1); 
-    deleteDistribution($3);
+  for(int len = 0x2; len <= n; len <<= 1){
+    int half = len >> 1, stride = n / len;
+    for(int start = 0x0; start < n; start += len){
+      for(int k = 0x0; k < half; ++k){
+        int i = start + k, j = i + half;
+        double t_re = re[j] * w_re[k * stride] - im[j] * w_im[k * stride];
+        double t_im = re[j] * w_im[k * stride] + im[j] * w_re[k * stride];
+        re[j] = re[i] - t_re;
+        im[j] = im[i] - t_im;
+        re[i] += t_re;
+        im[i] += t_im;
+      }
+    }
   }
-| DICE dice {
-    Distribution* d1 = createDistribution(0, 0, 1); 
-    $$ = dice(d1, $2); 
-    deleteDistribution(d1);
-    deleteDistribution($2);
+  free(w_re);
+  free(w_im);
+}
+
+
+Distribution* times(EvalContext* ctx, Distribution* d1, Distribution* d2){
+  ///printf("multiplying... \n");
+  double start = startStat(ctx);
+  if(!isUncertain(d1) && !isUncertain(d2)){
+    recordStat(ctx, STAT_TIMES, start, 1);
+    return createDistribution(ctx, 0x0, 0x0, d1->constant * d2->constant);
+  }else{
+    Distribution * d3 = combinePairs(ctx, d1, d2, true);
+    recordStat(ctx, STAT_TIMES, start, (double) (isUncertain(d1) ? d1->size : 0x1) * (isUncertain(d2) ? d2->size : 0x1));
+    return d3;
   }
-| term
-;
+}
 
-term:
-  INTEGER {$$ = createDistribution(0, 0, $1);}
-| DOUBLE {$$ = createDistribution(0, 0, $1);}
-| BRACKET_OPEN expr BRACKET_CLOSE {$$ = $2;}
-| function
-;
 
-function:
-  ROLL BRACKET_OPEN expr BRACKET_CLOSE {$$ = roll($3); deleteDistribution($3);}
-| AVG BRACKET_OPEN expr BRACKET_CLOSE {$$ = avg($3); deleteDistribution($3);}
-| PROB BRACKET_OPEN expr SEPERATOR expr BRACKET_CLOSE {
-    $$ = prob($3, $5); 
-    deleteDistribution($3); 
-    deleteDistribution($5);
+Distribution* dice(EvalContext* ctx, Distribution* d1, Distribution* d2){
+  //printf("dice operator, d1: (size: %d, const: %f), d2: (size: %d, const: %f)\n", d1->size, d1->constant, d2->size, d2->constant);
+  Distribution * d3, * d_side;
+  double start = startStat(ctx);
+  double nested = ctx->statement_stats.operators[STAT_ADD].elements;
+
+  if(isUncertain(d1) || isUncertain(d2)){
+    double operations, bytes;
+    estimateDice(ctx, d1, d2, &operations, &bytes);
+    if(operations <= ctx->exact_operations && bytes <= ctx->exact_bytes){
+      d3 = mixDice(ctx, d1, d2);
+      if(ctx->statement_engine == ENGINE_DIRECT) ctx->statement_engine = ENGINE_MIXTURE;
+      recordStat(ctx, STAT_DICE, start, ctx->statement_stats.operators[STAT_ADD].elements - nested);
+    }else{
+      d3 = sampleDice(ctx, d1, d2);
+      recordStat(ctx, STAT_DICE, start, ctx->statement_stats.operators[STAT_ADD].elements - nested + ctx->monte_carlo_samples);
+    }
+    return d3;
   }
-;
 
-%%
+  int const_1 = d1->constant;
+  int const_2 = d2->constant;
+  if(const_1 < 1 || const_2 < 1){
+    recordStat(ctx, STAT_DICE, start, 0);
+    return createDistribution(ctx, 0, 0, 0);
+  }
+  d_side = createDistribution(ctx, const_2, 0x1, 0x0);
+  d3 = power(ctx, d_side, const_1);
+  deleteDistribution(ctx, d_side);
+  recordStat(ctx, STAT_DICE, start, ctx->statement_stats.operators[STAT_ADD].elements - nested);
+  //print(d3);
+  return d3;
+}
 
-int active_distribution_count = 0;
+
+WeightedValue* getDiceOutcomes(Distribution* d, int* count){
+  int size = isUncertain(d) ? d->size : 1;
+  WeightedValue * outcomes = (WeightedValue *) malloc(sizeof(WeightedValue) * size);
+  double totalWeight = isUncertain(d) ? getTotalWeight(d) : 1;
+  int used = 0x0;
+  for(int i = 0x0; i < size; ++i){
+    double weight = isUncertain(d) ? d->distribution[i] / totalWeight : 1;
+    if(weight == 0) continue;
+    double value = trunc(isUncertain(d) ? getValue(d, i) : d->constant);
+    outcomes[used].value = value < 1 ? 0 : value;
+    outcomes[used++].weight = weight;
+  }
+  qsort(outcomes, used, sizeof(WeightedValue), compareValues);
+  int distinct = 0x0;
+  for(int i = 0x0; i < used; ++i){
+    if(distinct > 0x0 && outcomes[distinct - 1].value == outcomes[i].value){
+      outcomes[distinct - 1].weight += outcomes[i].weight;
+    }else{
+      outcomes[distinct++] = outcomes[i];
+    }
+  }
+  *count = distinct;
+  return outcomes;
+}
 
 
-double printResult(double result){
-  printf("--------------------\n"); 
-  printf("RESULT: %f\n", result); 
-  if(active_distribution_count > 0x0) printf("WARNING: Leaking distributions: %d\n", active_distribution_count);
-  printf("--------------------\n"); 
-  printf("Enter new Expression:\n"); 
+double estimateConvolution(double size_a, double size_b){
+  double size_out = size_a + size_b;
+  return fmin(size_a * size_b, CONVOLUTION_FFT_FACTOR * size_out * log2(size_out + 1));
 }
 
-Distribution * createDistribution(int size, double initVal, double constant){
-  Distribution * newDist = (Distribution *) malloc(sizeof(Distribution));
-  //printf("New Distribution [%ld]: Size: %d, InitVal: %f, Constant: %f\n", (long)newDist, size, initVal, constant);
-  newDist->size = size;
-  newDist->constant = constant;
-  if (size > 0x0){
-    newDist->distribution = (double*) malloc(sizeof(double) * size);
-    for(int i = 0x0; i < size; ++i){
-      newDist->distribution[i] = initVal;
-      //printf("creating: %d: %f\n", i, newDist->distribution[i]);
+
+void estimateDice(EvalContext* ctx, Distribution* d1, Distribution* d2, double* operations, double* bytes){
+  int count_n, count_s;
+  WeightedValue * counts = getDiceOutcomes(d1, &count_n);
+  WeightedValue * sides = getDiceOutcomes(d2, &count_s);
+  double max = counts[count_n - 1].value * sides[count_s - 1].value;
+  // the result, the current power, the next step and the temporary buffers of add
+  *bytes = sizeof(double) * 4 * (max + 1);
+  *operations = max;
+  if(max >= INT_MAX / 2) *operations = *bytes = INFINITY;
+
+  for(int j = 0x0; j < count_s && *operations <= ctx->exact_operations; ++j){
+    double s = sides[j].value;
+    if(s < 1) continue;
+    double previous = 0;
+    for(int i = 0x0; i < count_n && *operations <= ctx->exact_operations; ++i){
+      double n = counts[i].value;
+      if(n < 1) continue;
+      double step = n - previous;
+      // power(1ds, step): log2(step) squarings, then the addition to the previous power
+      *operations += 2 * log2(step + 1) * estimateConvolution(step * s, step * s);
+      if(previous > 0) *operations += estimateConvolution(previous * s, step * s);
+      // adding up the power into the result
+      *operations += n * s;
+      previous = n;
     }
-  }else{
-    newDist->distribution = NULL;
   }
-  //print(newDist);
-  active_distribution_count++;
-  return newDist;
+  free(counts);
+  free(sides);
 }
 
 
-void deleteDistribution(Distribution * dist){
-  //printf("deleting %ld\n", (long)dist);
-  if(dist->distribution != 0){
-    free(dist->distribution);
+Distribution* mixDice(EvalContext* ctx, Distribution* d1, Distribution* d2){
+  int count_n, count_s;
+  WeightedValue * counts = getDiceOutcomes(d1, &count_n);
+  WeightedValue * sides = getDiceOutcomes(d2, &count_s);
+  int max = counts[count_n - 1].value * sides[count_s - 1].value;
+
+  // cell i holds the value i (the value 0 stands for the counts or sides below 1)
+  Distribution * result = createDistribution(ctx, max + 1, 0x0, 0x0);
+  result->offset = 0;
+  for(int j = 0x0; j < count_s; ++j){
+    int s = sides[j].value;
+    if(s < 1){
+      result->distribution[0] += sides[j].weight;
+      continue;
+    }
+    Distribution * base = createDistribution(ctx, s, 0x1, 0x0);
+    Distribution * current = NULL;
+    int previous = 0;
+    for(int i = 0x0; i < count_n; ++i){
+      int n = counts[i].value;
+      double weight = sides[j].weight * counts[i].weight;
+      if(n < 1){
+        result->distribution[0] += weight;
+        continue;
+      }
+      Distribution * step = power(ctx, base, n - previous);
+      if(current == NULL){
+        current = step;
+      }else{
+        Distribution * next = add(ctx, current, step);
+        deleteDistribution(ctx, current);
+        deleteDistribution(ctx, step);
+        current = next;
+      }
+      previous = n;
+
+      weight /= getTotalWeight(current);
+      for(int k = 0x0; k < current->size; ++k){
+        result->distribution[(int) round(getValue(current, k))] += weight * current->distribution[k];
+      }
+    }
+    if(current != NULL) deleteDistribution(ctx, current);
+    deleteDistribution(ctx, base);
   }
-  free(dist);
-  active_distribution_count--;
-  //printf("Remaining active distributions: %d\n", active_distribution_count);
+  free(counts);
+  free(sides);
+  return chooseForm(ctx, result);
 }
 
 
-bool isUncertain(Distribution * dist){
-  return dist->size > 0x0;
+double drawOperand(RandomState* state, Distribution* d){
+  if(!isUncertain(d)) return d->constant;
+  return getValue(d, drawIndex(state, d->sampler));
 }
 
 
-double getMax(Distribution * dist){
-  return dist->size + dist->constant;
+void buildDiceTables(EvalContext* ctx, MonteCarloJob* job, Distribution* counts, Distribution* sides){
+  int count_n;
+  WeightedValue * count_outcomes = getDiceOutcomes(counts, &count_n);
+  double max_count = count_outcomes[count_n - 1].value;
+  free(count_outcomes);
+  job->sides = getDiceOutcomes(sides, &job->side_count);
+  job->tables = (Distribution **) calloc((size_t) job->side_count * MONTE_CARLO_LEVELS, sizeof(Distribution *));
+  job->table_count = 0;
+  if(max_count <= MONTE_CARLO_EXACT_DICE || max_count >= ldexp(1, MONTE_CARLO_LEVELS)) return;
+  int levels = (int) log2(max_count) + 1;
+
+  // every cell of a table takes its weight and its alias table entry (a double and an int)
+  double bytes = 0, operations = 0;
+  for(int j = 0x0; j < job->side_count; ++j){
+    double s = job->sides[j].value;
+    if(s >= 1){
+      for(int k = 0x1; k < levels; ++k){
+        operations += estimateConvolution(ldexp(s, k - 1), ldexp(s, k - 1));
+        if(ldexp(1, k) >= MONTE_CARLO_EXACT_DICE) bytes += ldexp(s, k) * (2 * sizeof(double) + sizeof(int));
+      }
+      if(bytes > ctx->exact_bytes || operations > ctx->exact_operations) break;
+
+      Distribution ** tables = job->tables + (size_t) j * MONTE_CARLO_LEVELS;
+      Distribution * square = createDistribution(ctx, (int) s, 0x1, 0x0);
+      for(int k = 0x1; k < levels; ++k){
+        Distribution * next = add(ctx, square, square);
+        if(tables[k - 1] == NULL) deleteDistribution(ctx, square);
+        square = next;
+        if(ldexp(1, k) >= MONTE_CARLO_EXACT_DICE){
+          square->sampler = createSampler(square);
+          tables[k] = square;
+        }
+      }
+      if(tables[levels - 1] == NULL) deleteDistribution(ctx, square);
+    }
+    job->table_count = j + 1;
+  }
 }
 
 
-double getTotalWeight(Distribution * dist){
-  double totalWeight = 0;
-  for(int i = 0; i < dist->size; i++){
-    totalWeight += dist->distribution[i];
+Distribution** findDiceTables(MonteCarloJob* job, double s){
+  int low = 0x0, high = job->table_count - 1;
+  while(low <= high){
+    int middle = (low + high) / 2;
+    if(job->sides[middle].value < s){
+      low = middle + 1;
+    }else if(job->sides[middle].value > s){
+      high = middle - 1;
+    }else{
+      return job->tables + (size_t) middle * MONTE_CARLO_LEVELS;
+    }
   }
-  return totalWeight;
+  return NULL;
 }
 
 
-void print(Distribution * dist){
-  printf("----- PRINTING %ld -----\n", (long)dist);
-  if(isUncertain(dist)){
-    printf("Distribution: \n");
-    double totalWeight = getTotalWeight(dist);
-    for(int i = 0; i < dist->size; ++i){
-      printf("%i: %.80f\n", (int)(i + dist->constant + 1), dist->distribution[i], totalWeight == 0 ? 0 : (dist->distribution[i] / totalWeight));
+void* runMonteCarlo(void* arg){
+  MonteCarloJob * job = (MonteCarloJob *) arg;
+  RandomState state;
+  for(;;){
+    pthread_mutex_lock(&job->lock);
+    int chunk = job->next_chunk++;
+    pthread_mutex_unlock(&job->lock);
+    if(chunk >= MONTE_CARLO_CHUNKS) return NULL;
+
+    seedState(&state, job->seed ^ mixBits(chunk + 1));
+    double * values = job->values + chunk * job->samples_per_chunk;
+    long approximated = 0;
+    for(long k = 0x0; k < job->samples_per_chunk; ++k){
+      double n = trunc(drawOperand(&state, job->counts));
+      double s = trunc(drawOperand(&state, job->dice_sides));
+      double sum = 0;
+      Distribution ** tables = n > MONTE_CARLO_EXACT_DICE ? findDiceTables(job, s) : NULL;
+      if(n >= 1 && s >= 1 && (tables != NULL || n <= MONTE_CARLO_ROLLED_DICE)){
+        // the groups of 2^k dice making up n, drawn from their table or rolled one by one
+        long long count = (long long) n;
+        for(int level = 0x0; level < MONTE_CARLO_LEVELS && count >> level > 0; ++level){
+          if(!(count >> level & 0x1)) continue;
+          if(tables != NULL && tables[level] != NULL){
+            sum += drawOperand(&state, tables[level]);
+          }else{
+            for(long long i = 0x0; i < 1LL << level; ++i){
+              sum += 1 + (long long) (uniformState(&state) * s);
+            }
+          }
+        }
+      }else if(n >= 1 && s >= 1){
+        // Box-Muller transform, rounded to the integer grid and clamped to [n, n * s]
+        double u = 1 - uniformState(&state), v = uniformState(&state);
+        double normal = sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+        sum = round(n * (s + 1) / 2 + normal * sqrt(n * (s * s - 1) / 12));
+        sum = fmin(fmax(sum, n), n * s);
+        approximated++;
+      }
+      values[k] = sum;
     }
-  }else{
-    printf("Constant: %f\n", dist->constant);
+    pthread_mutex_lock(&job->lock);
+    job->approximated += approximated;
+    pthread_mutex_unlock(&job->lock);
   }
-  printf("--------------------\n");
 }
 
 
+Distribution* sampleDice(EvalContext* ctx, Distribution* d1, Distribution* d2){
+  // the alias tables are built before the threads only read them
+  if(isUncertain(d1) && d1->sampler == NULL) d1->sampler = createSampler(d1);
+  if(isUncertain(d2) && d2->sampler == NULL) d2->sampler = createSampler(d2);
+
+  MonteCarloJob job;
+  job.counts = d1;
+  job.dice_sides = d2;
+  buildDiceTables(ctx, &job, d1, d2);
+  job.samples_per_chunk = (ctx->monte_carlo_samples + MONTE_CARLO_CHUNKS - 1) / MONTE_CARLO_CHUNKS;
+  job.seed = nextRandom(ctx);
+  job.next_chunk = 0;
+  job.approximated = 0;
+  long samples = job.samples_per_chunk * MONTE_CARLO_CHUNKS;
+  job.values = (double *) malloc(sizeof(double) * samples);
+  pthread_mutex_init(&job.lock, NULL);
+
+  int thread_count = ctx->monte_carlo_threads < MONTE_CARLO_CHUNKS ? ctx->monte_carlo_threads : MONTE_CARLO_CHUNKS;
+  pthread_t * threads = (pthread_t *) malloc(sizeof(pthread_t) * thread_count);
+  for(int i = 0x1; i < thread_count; ++i){
+    pthread_create(&threads[i], NULL, runMonteCarlo, &job);
+  }
+  runMonteCarlo(&job);
+  for(int i = 0x1; i < thread_count; ++i){
+    pthread_join(threads[i], NULL);
+  }
+  pthread_mutex_destroy(&job.lock);
+  free(threads);
+  for(int i = 0x0; i < job.side_count * MONTE_CARLO_LEVELS; ++i){
+    if(job.tables[i] != NULL) deleteDistribution(ctx, job.tables[i]);
+  }
+  free(job.tables);
+  free(job.sides);
 
-double resolve(Distribution * d){
-  ///printf("resolving... \n");
-  print(d);
-  double result = d->constant;
-  if(isUncertain(d)){
-    //print(d);
-    Distribution * dn = roll(d);
-    result = dn->constant;
-    deleteDistribution(dn);
+  WeightedValue * pairs = (WeightedValue *) malloc(sizeof(WeightedValue) * samples);
+  for(long k = 0x0; k < samples; ++k){
+    pairs[k].value = job.values[k];
+    pairs[k].weight = 1.0 / samples;
   }
+  free(job.values);
+  Distribution * result = collectValues(ctx, pairs, (int) samples, 0x0);
+  free(pairs);
+
+  if(ctx->statement_engine < ENGINE_MONTE_CARLO || samples < ctx->statement_samples){
+    ctx->statement_samples = samples;
+  }
+  if(job.approximated > 0) ctx->statement_engine = ENGINE_APPROXIMATION;
+  else if(ctx->statement_engine < ENGINE_MONTE_CARLO) ctx->statement_engine = ENGINE_MONTE_CARLO;
+  ctx->monte_carlo_runs++;
   return result;
 }
 
 
-Distribution * add(Distribution * d1, Distribution * d2){
-  ///printf("adding... \n");
-  Distribution * d3 = createDistribution(d1->size + d2->size, 0x0, d1->constant + d2->constant);
-  double weight1 = getTotalWeight(d1);
-  double weight2 = getTotalWeight(d2);
-  if(isUncertain(d1) && isUncertain(d2)){
-    for(int i = 0x0; i < d1->size; ++i){
-      for(int j = 0x0; j < d2->size; ++j){
-        int index = i + j + 0x1; // (i+1) + (j+1) - 1 wegen Indizierung
-        d3->distribution[index] += d1->distribution[i]/weight1 * d2->distribution[j]/weight2;
+Distribution* power(EvalContext* ctx, Distribution* base, int n){
+  Distribution * result = NULL;
+  Distribution * square = copyDistribution(ctx, base);
+  Distribution * d_temp;
+
+  while(n > 0){
+    if(n & 0x1){
+      if(result == NULL){
+        result = copyDistribution(ctx, square);
+      }else{
+        d_temp = add(ctx, result, square);
+        deleteDistribution(ctx, result);
+        result = d_temp;
       }
     }
-  }else if(isUncertain(d1)){
-    for(int i = 0x0; i < d1->size; ++i){
-      d3->distribution[i] = d1->distribution[i];
-    }
-  }else if(isUncertain(d2)){
-    for(int i = 0x0; i < d2->size; ++i){
-      d3->distribution[i] = d2->distribution[i];
+    n >>= 1;
+    if(n > 0){
+      d_temp = add(ctx, square, square);
+      deleteDistribution(ctx, square);
+      square = d_temp;
     }
   }
-  
-  return d3;
+  deleteDistribution(ctx, square);
+  return result;
 }
 
 
-Distribution* times(Distribution* d1, Distribution* d2){
-  ///printf("multiplying... \n");
-  if(!isUncertain(d1) && !isUncertain(d2)){
-    return createDistribution(0x0, 0x0, d1->constant * d2->constant);
-  }else{
-    Distribution * d3 = createDistribution(getMax(d1) * getMax(d2), 0x0, 0x0);
-    double weight1, weight2; 
-
-    if(isUncertain(d1) && isUncertain(d2)){
-      weight1 = getTotalWeight(d1);
-      weight2 = getTotalWeight(d2);
-      for(int i = 0; i < d1->size; ++i){
-        for(int j = 0; j < d2->size; ++j){
-          int value = (i + ((int)d1->constant) + 1) * (j + ((int)d2->constant) + 1);
-          d3->distribution[(int)(value - 1)] += d1->distribution[i]/weight1 * d2->distribution[j]/weight2;
-        }
-      }
-    }else if(isUncertain(d1)){
-      weight1 = getTotalWeight(d1);
-      for(int i = 0x0; i < d1->size; ++i){
-        d3->distribution[(int)(((i + d1->constant) + 1)*d2->constant) - 1] = d1->distribution[i]/weight1;
-      }
-    }else if(isUncertain(d2)){
-      weight2 = getTotalWeight(d2);
-      for(int i = 0x0; i < d2->size; ++i){
-        d3->distribution[(int)(((i + d2->constant) + 1)*d1->constant) - 1] = d2->distribution[i]/weight2;
-      }
-    }
-    return d3;
+Distribution* roll(EvalContext* ctx, Distribution* d) {
+  ///printf("rolling... \n");
+  double result = d->constant;
+  if(isUncertain(d)){
+    double start = startStat(ctx);
+    // building the alias table counts as one element operation per cell
+    double elements = 1 + (d->sampler == NULL ? d->size : 0);
+    result = getValue(d, sampleIndex(ctx, d));
+    recordStat(ctx, STAT_ROLL, start, elements);
   }
+  return createDistribution(ctx, 0, 0, result);
 }
 
 
-Distribution* dice(Distribution* d1, Distribution* d2){
-  //printf("dice operator, d1: (size: %d, const: %f), d2: (size: %d, const: %f)\n", d1->size, d1->constant, d2->size, d2->constant);
-  Distribution * d3, * d_temp, * d3_temp, * d_add;
-  int const_1 = 0;
-  int const_2 = 0;
-
-  if(isUncertain(d1)){
-    d_temp = roll(d1);
-    const_1 = d_temp->constant;
-    deleteDistribution(d_temp);
+Distribution* rollMany(EvalContext* ctx, Distribution* d, Distribution* count){
+  int n = 0;
+  if(isUncertain(count)){
+    Distribution * d_temp = roll(ctx, count);
+    n = d_temp->constant;
+    deleteDistribution(ctx, d_temp);
   }else{
-    const_1 = d1->constant;
+    n = count->constant;
   }
 
-  if(isUncertain(d2)){
-    d_temp = roll(d2);
-    const_2 = d_temp->constant;
-    deleteDistribution(d_temp);
-  }else{
-    const_2 = d2->constant;
-  }
+  if(n < 1) return createDistribution(ctx, 0, 0, 0);
+  if(!isUncertain(d)) return createDistribution(ctx, 0, 0, d->constant);
 
-  if(const_1 == 0 | const_2 == 0) return createDistribution(0, 0, 0);
-  d3 = createDistribution(const_2, 0x1, 0x0);
-  d_add = createDistribution(const_2, 1, 0);
-  for(int i = 1; i < const_1; i++){
-    d3_temp = add(d3, d_add);
-    deleteDistribution(d3);
-    d3 = d3_temp;
+  double start = startStat(ctx);
+  double elements = n + (d->sampler == NULL ? d->size : 0);
+  Distribution * histogram = copyDistribution(ctx, d);
+  memset(histogram->distribution, 0, sizeof(double) * d->size);
+  histogram->key = 0;
+  for(int i = 0x0; i < n; ++i){
+    histogram->distribution[sampleIndex(ctx, d)] += 1;
   }
-  deleteDistribution(d_add);
-  //print(d3);
-  return d3;
+  histogram = chooseForm(ctx, histogram);
+  recordStat(ctx, STAT_ROLL, start, elements);
+  return histogram;
 }
 
 
-Distribution* avg(Distribution* d){
-  ///printf("averaging... \n");
-  if(!isUncertain(d)) return createDistribution(0, 0, d->constant);
-  double sum = 0;
-  double totalWeight = 0;
-  for(int i = 0x0; i < d->size; i++){
-    sum += d->distribution[i] * (i + d->constant);
-    totalWeight += d->distribution[i];
+int sampleIndex(EvalContext* ctx, Distribution* d){
+  if(d->sampler == NULL){
+    d->sampler = createSampler(d);
   }
-  return createDistribution(0, 0, sum / totalWeight);
+  return drawIndex(&ctx->random_state, d->sampler);
 }
 
 
-Distribution* roll(Distribution* d) {
-  ///printf("rolling... \n");
-  double result = d->constant;
-  if(isUncertain(d)){
-    double totalWeight = getTotalWeight(d);
-    result += 1 + divideAndRoll(d->distribution, 0, d->size-1, totalWeight);
-  }
-  return createDistribution(0, 0, result);
+int drawIndex(RandomState* state, Sampler* sampler){
+  int column = stepState(state) % sampler->size;
+  return uniformState(state) < sampler->threshold[column] ? column : sampler->alias[column];
 }
 
 /*
@@ -437,85 +2615,132 @@ Distribution* roll(Distribution* d) {
 *   because of that, probabilities smaller than 1/RAND_MAX could never be represented.
 *
 *   Solution:
-*   I divide up the array of probabilities recursively, grouping it into sections which have
-*   a combined probability of ~50% of the total array probability.
-*   
-*   prob: complete array of probabilities
-*   start_index: starting index of the section of this iteration
-*   end_index: ending index (inclusive) of the section
-*   sectionWeight: 
-*   
+*   Rolls are drawn from a 64 bit generator (see nextRandom), a cell with probability p
+*   ends up in a column it is kept in with the probability p * size, which is compared
+*   against a 53 bit uniform double. So probabilities down to 2^-53 / size are still rolled.
+*
+*   Vose's method: every column is filled up to the average weight, first with a cell
+*   below the average ("small") and then with the rest from a cell above it ("large").
 */
-int divideAndRoll(double* prob, int start_index, int end_index, double sectionWeight){
-  //printf("start_index: %d, end_index: %d\n", start_index, end_index);
-  double weight_section1 = 0;
-  double weight_section2 = 0;
-  int divider = -1;
-
-  if(start_index == end_index) return start_index;
-
-  /*
-    Divide the array into sections [start_index, divider] and [divider+1, end_index].
-    Calculate the partial weights of these subsections
-  */
-  for(int i = start_index; i <= end_index; i++){
-    if(divider == -1){
-      weight_section1 += prob[i];
-      if(weight_section1 > 0.5 * sectionWeight){
-        divider = i;
-      }
+Sampler* createSampler(Distribution* d){
+  int size = d->size;
+  Sampler * sampler = (Sampler *) malloc(sizeof(Sampler));
+  sampler->size = size;
+  sampler->threshold = (double*) malloc(sizeof(double) * size);
+  sampler->alias = (int*) malloc(sizeof(int) * size);
+
+  double totalWeight = getTotalWeight(d);
+  double * scaled = sampler->threshold;
+  int * small = (int*) malloc(sizeof(int) * size);
+  int * large = (int*) malloc(sizeof(int) * size);
+  int small_count = 0, large_count = 0;
+
+  for(int i = 0x0; i < size; ++i){
+    // a distribution without any weight is rolled uniformly
+    scaled[i] = totalWeight > 0 ? d->distribution[i] * size / totalWeight : 1;
+    sampler->alias[i] = i;
+    if(scaled[i] < 1){
+      small[small_count++] = i;
     }else{
-      weight_section2 += prob[i];
+      large[large_count++] = i;
     }
   }
 
-  //Proportional probabilites
-  double prop_prob_section1, prop_prob_section2;
-
-  /* Edge Case: if the first section needs all elements summed up to reach the threshhold
-  *  (when the last element on its own has > 50% of the total probability)
-  *  -> move last element to second section
-  */
-  if(weight_section2 == 0){
-    weight_section1 -= prob[divider];
-    weight_section2 += prob[divider];
-    divider -= 1;
+  while(small_count > 0 && large_count > 0){
+    int s = small[--small_count];
+    int l = large[large_count - 1];
+    sampler->alias[s] = l;
+    scaled[l] -= 1 - scaled[s];
+    if(scaled[l] < 1){
+      large_count--;
+      small[small_count++] = l;
+    }
   }
+  // whatever remains is (up to rounding errors) exactly at the average
+  while(large_count > 0) scaled[large[--large_count]] = 1;
+  while(small_count > 0) scaled[small[--small_count]] = 1;
 
-  if(start_index == divider){
-    start_index++;
-  }else if(end_index == divider){
-    end_index--;
-  }
+  free(small);
+  free(large);
+  return sampler;
+}
 
-  prop_prob_section1 = weight_section1 / sectionWeight;
-  int rand_part1 = (int) RAND_MAX * prop_prob_section1;
 
-  if(rand() <= rand_part1){
-    return divideAndRoll(prob, start_index, divider, weight_section1);
-  }else{
-    return divideAndRoll(prob, divider+0x1, end_index, weight_section2);
+void deleteSampler(Sampler* sampler){
+  free(sampler->threshold);
+  free(sampler->alias);
+  free(sampler);
+}
+
+
+void seedRandom(EvalContext* ctx, unsigned long long seed){
+  seedState(&ctx->random_state, seed);
+}
+
+
+unsigned long long nextRandom(EvalContext* ctx){
+  return stepState(&ctx->random_state);
+}
+
+
+void seedState(RandomState* state, unsigned long long seed){
+  for(int i = 0x0; i < 4; ++i){
+    state->s[i] = mixBits(seed += 0x9E3779B97F4A7C15ULL);
   }
 }
 
 
-Distribution* prob(Distribution* d1, Distribution* d2){
+unsigned long long stepState(RandomState* state){
+  unsigned long long * s = state->s;
+  unsigned long long x = s[1] * 5;
+  unsigned long long result = ((x << 7) | (x >> 57)) * 9;
+  unsigned long long t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = (s[3] << 45) | (s[3] >> 19);
+  return result;
+}
+
+
+double uniformState(RandomState* state){
+  return (stepState(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+Distribution* prob(EvalContext* ctx, Distribution* d1, Distribution* d2){
   //printf("prob\n");
   double probability = 0;
   double const_1 = 0;
   if(isUncertain(d1)){
     //if d1 is a dice, roll it first
-    Distribution * d_temp = roll(d1);
-    const_1 = d1->constant;
-    deleteDistribution(d_temp);
+    Distribution * d_temp = roll(ctx, d1);
+    const_1 = d_temp->constant;
+    deleteDistribution(ctx, d_temp);
   }else{
     //if d1 is a constant
     const_1 = d1->constant;
   }
 
   if(isUncertain(d2)){
-    if(const_1 < getMax(d2)){
-      probability = d2->distribution[(int)(const_1 - d2->constant)];
+    int index = -1;
+    if(isSparse(d2)){
+      // binary search for the first value not below const_1
+      int low = 0x0, high = d2->size;
+      while(low < high){
+        int middle = (low + high) / 2;
+        if(getValue(d2, middle) < const_1 - VALUE_EPSILON) low = middle + 1;
+        else high = middle;
+      }
+      if(low < d2->size && fabs(getValue(d2, low) - const_1) <= VALUE_EPSILON) index = low;
+    }else{
+      double cell = const_1 - d2->constant - d2->offset;
+      if(fabs(cell - round(cell)) <= VALUE_EPSILON && round(cell) >= 0 && round(cell) < d2->size) index = round(cell);
+    }
+    if(index >= 0x0){
+      probability = d2->distribution[index];
       probability /= getTotalWeight(d2);
     }
   }else {
@@ -524,6 +2749,335 @@ Distribution* prob(Distribution* d1, Distribution* d2){
     }
   }
   
-  return createDistribution(0, 0, probability);
+  return createDistribution(ctx, 0, 0, probability);
+}
+
+
+Distribution* apply(EvalContext* ctx, Operator op, Distribution* d1, Distribution* d2){
+  unsigned long long key_1 = getKey(d1);
+  unsigned long long key_2 = d2 == NULL ? 0x1 : getKey(d2);
+  bool deterministic = true;
+  if(op == OP_PROB) deterministic = !isUncertain(d1);
+  bool constant = op != OP_DICE && !isUncertain(d1) && (d2 == NULL || !isUncertain(d2));
+
+  // addition and multiplication commute, so both orders share one entry
+  if((op == OP_ADD || op == OP_TIMES) && key_1 > key_2){
+    unsigned long long t = key_1; key_1 = key_2; key_2 = t;
+  }
+  unsigned long long key = deterministic && !constant ? combineKeys(op, key_1, key_2) : 0;
+
+  Distribution * result = NULL;
+  if(key != 0 && ctx->distribution_cache.capacity > 0){
+    result = cacheLookup(ctx, op, key, key_1, key_2);
+    if(result != NULL){
+      ctx->distribution_cache.hits++;
+      // sampled dice are never cached, so a cached mixture was computed exactly
+      if(op == OP_DICE && (isUncertain(d1) || isUncertain(d2)) && ctx->statement_engine == ENGINE_DIRECT){
+        ctx->statement_engine = ENGINE_MIXTURE;
+      }
+      return result;
+    }
+    ctx->distribution_cache.misses++;
+  }
+
+  long monte_carlo_runs = ctx->monte_carlo_runs;
+  switch(op){
+    case OP_ADD: result = add(ctx, d1, d2); break;
+    case OP_TIMES: result = times(ctx, d1, d2); break;
+    case OP_DICE: result = dice(ctx, d1, d2); break;
+    case OP_PROB: result = prob(ctx, d1, d2); break;
+  }
+  if(ctx->monte_carlo_runs != monte_carlo_runs || ctx->statement_failed) key = 0;
+  result->key = isUncertain(result) ? key : 0;
+
+  if(key != 0 && ctx->distribution_cache.capacity > 0){
+    cacheStore(ctx, op, key, key_1, key_2, result);
+  }
+  return result;
+}
+
+
+Expression* createExpression(EvalContext* ctx, ExpressionKind kind, Expression* left, Expression* right, double constant){
+  Expression * expr = (Expression *) malloc(sizeof(Expression));
+  expr->kind = kind;
+  expr->constant = constant;
+  expr->left = left;
+  expr->right = right;
+  expr->drawn = NULL;
+  return expr;
+}
+
+
+void deleteExpression(EvalContext* ctx, Expression* expr){
+  if(expr == NULL) return;
+  deleteExpression(ctx, expr->left);
+  deleteExpression(ctx, expr->right);
+  if(expr->drawn != NULL) deleteDistribution(ctx, expr->drawn);
+  free(expr);
+}
+
+
+Distribution* materialize(EvalContext* ctx, Expression* expr){
+  if(expr->drawn != NULL) return copyDistribution(ctx, expr->drawn);
+  Distribution * d1, * d2, * result;
+  Moments moments;
+  RandomState state;
+  switch(expr->kind){
+    case EXPR_VALUE:
+      return createDistribution(ctx, 0, 0, expr->constant);
+    case EXPR_AVG:
+    case EXPR_VAR:
+    case EXPR_STDDEV:
+      getMoments(ctx, expr->left, &moments);
+      if(expr->kind == EXPR_AVG) return createDistribution(ctx, 0, 0, moments.mean);
+      if(expr->kind == EXPR_VAR) return createDistribution(ctx, 0, 0, moments.variance);
+      return createDistribution(ctx, 0, 0, sqrt(moments.variance));
+    default:
+      break;
+  }
+
+  // the operands keep their own draws, only the draws of this node are checked
+  d1 = materialize(ctx, expr->left);
+  d2 = expr->kind == EXPR_ROLL ? NULL : materialize(ctx, expr->right);
+  state = ctx->random_state;
+  switch(expr->kind){
+    case EXPR_ADD: result = apply(ctx, OP_ADD, d1, d2); break;
+    case EXPR_TIMES: result = apply(ctx, OP_TIMES, d1, d2); break;
+    case EXPR_DICE: result = apply(ctx, OP_DICE, d1, d2); break;
+    case EXPR_PROB: result = apply(ctx, OP_PROB, d1, d2); break;
+    case EXPR_ROLL: result = roll(ctx, d1); break;
+    default: result = rollMany(ctx, d1, d2); break;
+  }
+  deleteDistribution(ctx, d1);
+  if(d2 != NULL) deleteDistribution(ctx, d2);
+  if(memcmp(&state, &ctx->random_state, sizeof(RandomState)) != 0) expr->drawn = copyDistribution(ctx, result);
+  return result;
+}
+
+
+void getMoments(EvalContext* ctx, Expression* expr, Moments* moments){
+  Moments m1, m2;
+  switch(expr->kind){
+    case EXPR_VALUE:
+      moments->mean = moments->min = moments->max = expr->constant;
+      moments->variance = 0;
+      moments->integral = expr->constant == floor(expr->constant);
+      return;
+
+    case EXPR_ADD:
+      getMoments(ctx, expr->left, &m1);
+      getMoments(ctx, expr->right, &m2);
+      moments->mean = m1.mean + m2.mean;
+      moments->variance = m1.variance + m2.variance;
+      moments->min = m1.min + m2.min;
+      moments->max = m1.max + m2.max;
+      moments->integral = m1.integral && m2.integral;
+      return;
+
+    case EXPR_TIMES:
+      getMoments(ctx, expr->left, &m1);
+      getMoments(ctx, expr->right, &m2);
+      moments->mean = m1.mean * m2.mean;
+      moments->variance = m1.variance * m2.variance + m1.variance * m2.mean * m2.mean + m2.variance * m1.mean * m1.mean;
+      moments->min = fmin(fmin(m1.min * m2.min, m1.min * m2.max), fmin(m1.max * m2.min, m1.max * m2.max));
+      moments->max = fmax(fmax(m1.min * m2.min, m1.min * m2.max), fmax(m1.max * m2.min, m1.max * m2.max));
+      moments->integral = m1.integral && m2.integral;
+      return;
+
+    case EXPR_DICE:
+      getMoments(ctx, expr->left, &m1);
+      getMoments(ctx, expr->right, &m2);
+      // constant operands are truncated like in dice(), below 1 they result in 0
+      if(m1.min == m1.max){
+        m1.mean = m1.min = m1.max = (int) m1.min;
+        m1.integral = true;
+      }
+      if(m2.min == m2.max){
+        m2.mean = m2.min = m2.max = (int) m2.min;
+        m2.integral = true;
+      }
+      if((m1.min == m1.max && m1.min < 1) || (m2.min == m2.max && m2.min < 1)){
+        moments->mean = moments->variance = moments->min = moments->max = 0;
+        moments->integral = true;
+        return;
+      }
+      if(m1.integral && m2.integral && m1.min >= 0 && m2.min >= 1){
+        double die_mean = (m2.mean + 1) / 2;
+        double die_variance = (m2.variance + m2.mean * m2.mean - 1) / 12;
+        double die_mean_variance = m2.variance / 4;
+        moments->mean = m1.mean * die_mean;
+        moments->variance = m1.mean * die_variance
+                          + m1.variance * (die_mean_variance + die_mean * die_mean)
+                          + m1.mean * m1.mean * die_mean_variance;
+        moments->min = m1.min;
+        moments->max = m1.max * m2.max;
+        moments->integral = true;
+        return;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  Distribution * dist = materialize(ctx, expr);
+  getDistributionMoments(dist, moments);
+  deleteDistribution(ctx, dist);
+}
+
+
+void getDistributionMoments(Distribution* dist, Moments* moments){
+  moments->mean = moments->min = moments->max = dist->constant;
+  moments->variance = 0;
+  moments->integral = dist->constant == floor(dist->constant);
+  if(!isUncertain(dist)) return;
+
+  double sum = 0;
+  double totalWeight = 0;
+  bool first = true;
+  for(int i = 0x0; i < dist->size; i++){
+    if(dist->distribution[i] == 0) continue;
+    double value = getValue(dist, i);
+    sum += dist->distribution[i] * value;
+    totalWeight += dist->distribution[i];
+    if(first || value < moments->min) moments->min = value;
+    if(first || value > moments->max) moments->max = value;
+    if(value != floor(value)) moments->integral = false;
+    first = false;
+  }
+  moments->mean = sum / totalWeight;
+  double squares = 0;
+  for(int i = 0x0; i < dist->size; i++){
+    double deviation = getValue(dist, i) - moments->mean;
+    squares += dist->distribution[i] * deviation * deviation;
+  }
+  moments->variance = squares / totalWeight;
+}
+
+
+unsigned long long getKey(Distribution* dist){
+  if(isUncertain(dist)) return dist->key;
+  unsigned long long bits = 0;
+  double value = dist->constant == 0 ? 0 : dist->constant; // -0.0 equals 0.0
+  memcpy(&bits, &value, sizeof(double));
+  unsigned long long key = mixBits(bits + 0x9E3779B97F4A7C15ULL);
+  return key == 0 ? 0x1 : key;
+}
+
+
+unsigned long long combineKeys(Operator op, unsigned long long key_1, unsigned long long key_2){
+  if(key_1 == 0 || key_2 == 0) return 0;
+  unsigned long long z = mixBits((op + 0x1) * 0x9E3779B97F4A7C15ULL ^ key_1);
+  z = mixBits(z ^ key_2);
+  return z == 0 ? 0x1 : z;
+}
+
+
+unsigned long long mixBits(unsigned long long z){
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+
+void setCacheCapacity(EvalContext* ctx, size_t capacity){
+  ctx->distribution_cache.capacity = capacity;
+  cacheEvict(ctx, capacity);
+}
+
+
+Distribution* cacheLookup(EvalContext* ctx, Operator op, unsigned long long key, unsigned long long key_1, unsigned long long key_2){
+  DistributionCache * cache = &ctx->distribution_cache;
+  if(cache->bucket_count == 0) return NULL;
+
+  CacheEntry * entry = cache->buckets[key & (cache->bucket_count - 1)];
+  while(entry != NULL && !(entry->key == key && entry->op == op && entry->key_1 == key_1 && entry->key_2 == key_2)){
+    entry = entry->next_in_bucket;
+  }
+  if(entry == NULL) return NULL;
+
+  // move to the front of the recently used list
+  if(cache->newest != entry){
+    entry->newer->older = entry->older;
+    if(entry->older != NULL) entry->older->newer = entry->newer;
+    else cache->oldest = entry->newer;
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    cache->newest->newer = entry;
+    cache->newest = entry;
+  }
+
+  return copyDistribution(ctx, &entry->value);
+}
+
+
+void cacheStore(EvalContext* ctx, Operator op, unsigned long long key, unsigned long long key_1, unsigned long long key_2, Distribution* result){
+  DistributionCache * cache = &ctx->distribution_cache;
+  size_t bytes = sizeof(CacheEntry) + sizeof(double) * result->size * (isSparse(result) ? 2 : 1);
+  if(bytes > cache->capacity) return;
+  cacheEvict(ctx, cache->capacity - bytes);
+
+  if(cache->entry_count >= cache->bucket_count){
+    // grow the table, rehashing all entries
+    int bucket_count = cache->bucket_count == 0 ? 256 : cache->bucket_count * 2;
+    CacheEntry ** buckets = (CacheEntry **) calloc(bucket_count, sizeof(CacheEntry *));
+    for(CacheEntry * entry = cache->newest; entry != NULL; entry = entry->older){
+      int bucket = entry->key & (bucket_count - 1);
+      entry->next_in_bucket = buckets[bucket];
+      buckets[bucket] = entry;
+    }
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = bucket_count;
+  }
+
+  CacheEntry * entry = (CacheEntry *) malloc(sizeof(CacheEntry));
+  entry->op = op;
+  entry->key = key;
+  entry->key_1 = key_1;
+  entry->key_2 = key_2;
+  entry->value = *result;
+  entry->value.sampler = NULL;
+  if(isUncertain(result)){
+    entry->value.distribution = (double*) malloc(sizeof(double) * result->size);
+    memcpy(entry->value.distribution, result->distribution, sizeof(double) * result->size);
+  }
+  if(isSparse(result)){
+    entry->value.values = (double*) malloc(sizeof(double) * result->size);
+    memcpy(entry->value.values, result->values, sizeof(double) * result->size);
+  }
+
+  int bucket = key & (cache->bucket_count - 1);
+  entry->next_in_bucket = cache->buckets[bucket];
+  cache->buckets[bucket] = entry;
+  entry->newer = NULL;
+  entry->older = cache->newest;
+  if(cache->newest != NULL) cache->newest->newer = entry;
+  else cache->oldest = entry;
+  cache->newest = entry;
+
+  cache->entry_count++;
+  cache->bytes += bytes;
 }
 
+
+void cacheEvict(EvalContext* ctx, size_t limit){
+  DistributionCache * cache = &ctx->distribution_cache;
+  while(cache->bytes > limit && cache->oldest != NULL){
+    CacheEntry * entry = cache->oldest;
+
+    CacheEntry ** link = &cache->buckets[entry->key & (cache->bucket_count - 1)];
+    while(*link != entry) link = &(*link)->next_in_bucket;
+    *link = entry->next_in_bucket;
+
+    cache->oldest = entry->newer;
+    if(cache->oldest != NULL) cache->oldest->older = NULL;
+    else cache->newest = NULL;
+
+    cache->bytes -= sizeof(CacheEntry) + sizeof(double) * entry->value.size * (isSparse(&entry->value) ? 2 : 1);
+    cache->entry_count--;
+    free(entry->value.distribution);
+    free(entry->value.values);
+    free(entry);
+  }
+}